@@ -6,109 +6,2908 @@
 
 #include <set>
 #include <map>
-#include <regex>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
 #include <vector>
+#include <unordered_map>
 #include <string>
+#include <cstdlib>
+#include <type_traits>
 #include <algorithm>
 #include <iostream>
+#include <regex>
+#ifdef __linux__
+#include <thread>
+#include <dirent.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// exception-free mode, every MiniCommander operation is noexcept and errors are reported
+// by Status values, enabled automatically when compiling without exceptions (-fno-exceptions)
+#if !defined(MINICMD_NO_EXCEPTIONS) && !defined(__cpp_exceptions) && !defined(__EXCEPTIONS) && !defined(_CPPUNWIND)
+#define MINICMD_NO_EXCEPTIONS
+#endif
+#ifdef MINICMD_NO_EXCEPTIONS
+#define MINICMD_NOEXCEPT noexcept
+#else
+#define MINICMD_NOEXCEPT
+#endif
+
+#ifdef _WIN32
+#include <stdlib.h>
+#define MINICMD_ENVIRON _environ
+#else
+extern "C" {
+extern char** environ;
+}
+#define MINICMD_ENVIRON environ
+#endif
 
 enum class Policy {
     required,
     anyOf,
-    optional
+    optional,
+    exactlyOne,
+    atMostOne
 };
 
-struct OptionGroup {
-    Policy policy;
-    std::string groupDescription;
-    std::map<std::string, std::pair<std::string, std::string>> options;
-    OptionGroup(Policy p, std::string description) : policy(p), groupDescription(description) {}
-    void addOption(std::string flag, std::string desc = "", std::string alternativeFlag="") {
-        options[flag] = std::make_pair(desc, alternativeFlag);
+enum class Status {
+    ok,
+    tooManyTokens,
+    tooManyOptions,
+    invalidQuoting,
+    cannotReadFile,
+    unknownOption,
+    invalidValue,
+    missingOption,
+    missingParameter,
+    invalidFormat,
+    ambiguousOption,
+    unexpectedArgument
+};
+
+// classification of a token against the declared options
+enum class TokenKind {
+    flag,  // declared flag, alternative or member of a prefix family
+    parameter,  // any other token after a flag
+    positional,  // any other token before the first flag
+    unknown  // flag-like token that isn't declared
+};
+
+// number of parameters an option takes, options without a declared arity take all following
+// tokens up to the next option, with unixFlags up to the next token starting with -
+struct Arity {
+    size_t min;
+    size_t max;
+    static const size_t unbounded = static_cast<size_t>(-1);
+    static Arity none() noexcept { return Arity{0, 0}; }
+    static Arity exactly(size_t n) noexcept { return Arity{n, n}; }
+    static Arity range(size_t min, size_t max) noexcept { return Arity{min, max}; }
+    // any number of tokens up to the next declared flag, including ones like -5 or -x
+    static Arity untilNextFlag() noexcept { return Arity{0, unbounded}; }
+};
+
+// a value or the Status explaining why there is none
+template<class T>
+struct Expected {
+    T value;
+    Status status;
+    explicit operator bool() const noexcept { return status == Status::ok; }
+};
+
+// non-owning string view, not necessarily null-terminated, e.g. the -d split off -d=param in argv
+struct ArgView {
+    const char* data;
+    size_t size;
+    ArgView() noexcept : data(""), size(0) {}
+    ArgView(const char* str) noexcept : data(str), size(std::strlen(str)) {}
+    ArgView(const char* str, size_t length) noexcept : data(str), size(length) {}
+    template<class A>
+    ArgView(const std::basic_string<char, std::char_traits<char>, A>& str) noexcept : data(str.c_str()), size(str.size()) {}
+    bool empty() const noexcept { return size == 0; }
+    bool operator==(const char* str) const noexcept { return std::strncmp(data, str, size) == 0 && str[size] == '\0'; }
+    bool operator==(ArgView other) const noexcept { return size == other.size && std::memcmp(data, other.data, size) == 0; }
+    operator std::string() const { return std::string(data, size); }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const ArgView& view) {
+    return os.write(view.data, view.size);
+}
+
+// consecutive parameters of a flag
+struct ArgRange {
+    const ArgView* first;
+    size_t count;
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const ArgView& operator[](size_t i) const { return first[i]; }
+    const ArgView* begin() const { return first; }
+    const ArgView* end() const { return first + count; }
+};
+
+namespace minicmd {
+
+template<class Allocator, class T>
+using Rebind = typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+template<class Allocator>
+using String = std::basic_string<char, std::char_traits<char>, Rebind<Allocator, char>>;
+template<class Allocator, class T>
+using Vector = std::vector<T, Rebind<Allocator, T>>;
+template<class Allocator, class K, class V>
+using Map = std::map<K, V, std::less<K>, Rebind<Allocator, std::pair<const K, V>>>;
+
+// 64 bit FNV-1a, can be continued by passing the previous hash
+inline std::uint64_t hashBytes(const char* data, size_t size, std::uint64_t hash = 14695981039346656037ull) {
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// order-sensitive combination of two hashes
+inline std::uint64_t hashCombine(std::uint64_t seed, std::uint64_t value) {
+    return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+// splitmix64 finalizer, spreads the bits before hashes are combined commutatively
+inline std::uint64_t mixHash(std::uint64_t hash) {
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+    return hash ^ (hash >> 31);
+}
+
+// fixed-size integers in serialized data, in native byte order
+template<class S>
+void appendUint32(S& data, std::uint32_t value) {
+    data.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+inline std::uint32_t readUint32(const char* data) {
+    std::uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+struct StringHash {
+    template<class S>
+    size_t operator()(const S& str) const {
+        return static_cast<size_t>(hashBytes(str.data(), str.size()));
     }
 };
 
-class MiniCommander {
+template<class Allocator, class K, class V>
+using HashMap = std::unordered_map<K, V, StringHash, std::equal_to<K>, Rebind<Allocator, std::pair<const K, V>>>;
+
+// Levenshtein distance to a fixed pattern with Myers' bit-parallel algorithm, linear in the text length
+// for patterns up to 64 characters, longer ones fall back to the quadratic dynamic program
+class EditDistance {
 public:
-    MiniCommander(const int argc, char const*const* argv, bool unixFlags=false) : unixFlags(unixFlags) {
-        for (int i = 1; i < argc; ++i) {
-            std::string str = std::string(argv[i]);
-            if (unixFlags && std::regex_match(str, std::regex("^(-[a-zA-Z]{2,})(=.*$|$)"))) {
-                for (size_t f=1; f < str.size() && str[f-1] != '='; ++f)
-                    tokens.push_back((str[f] != '=') ? std::string{'-', str[f]} : str.substr(f + 1));
-            } else {
-                size_t equal_pos = str.find_first_of('=');
-                if (equal_pos == std::string::npos)
-                    tokens.push_back(str);
-                else {  // split argument with '='
-                    tokens.push_back(str.substr(0, equal_pos));
-                    tokens.push_back(str.substr(equal_pos + 1));
+    explicit EditDistance(ArgView pattern) : pattern(pattern) {
+        std::memset(peq, 0, sizeof(peq));
+        for (size_t i = 0; i < pattern.size && i < 64; ++i)
+            peq[static_cast<unsigned char>(pattern.data[i])] |= std::uint64_t(1) << i;
+    }
+
+    size_t operator()(ArgView text) const {
+        if (pattern.size == 0 || pattern.size > 64)
+            return dynamicProgram(text);
+        const std::uint64_t last = std::uint64_t(1) << (pattern.size - 1);
+        std::uint64_t pv = ~std::uint64_t(0), mv = 0;
+        size_t distance = pattern.size;
+        for (size_t j = 0; j < text.size; ++j) {
+            std::uint64_t eq = peq[static_cast<unsigned char>(text.data[j])];
+            std::uint64_t xv = eq | mv;
+            std::uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+            std::uint64_t ph = mv | ~(xh | pv);
+            std::uint64_t mh = pv & xh;
+            if (ph & last)
+                ++distance;
+            else if (mh & last)
+                --distance;
+            ph = (ph << 1) | 1;  // the first row grows by one per text character
+            mh <<= 1;
+            pv = mh | ~(xv | ph);
+            mv = ph & xv;
+        }
+        return distance;
+    }
+
+private:
+    size_t dynamicProgram(ArgView text) const {
+        std::vector<size_t> row(text.size + 1);
+        for (size_t j = 0; j <= text.size; ++j)
+            row[j] = j;
+        for (size_t i = 1; i <= pattern.size; ++i) {
+            size_t diagonal = row[0];
+            row[0] = i;
+            for (size_t j = 1; j <= text.size; ++j) {
+                size_t above = row[j];
+                row[j] = std::min(std::min(row[j] + 1, row[j - 1] + 1), diagonal + (pattern.data[i - 1] != text.data[j - 1]));
+                diagonal = above;
+            }
+        }
+        return row[text.size];
+    }
+
+    ArgView pattern;
+    std::uint64_t peq[256];  // bit i is set for the characters at position i of the pattern
+};
+
+// collision-free table of a fixed set of strings, built with hash and displace: the keys are hashed into buckets
+// and each bucket gets a displacement that moves all of its keys to free slots, so find() hashes the key once
+// and compares it with at most one of them
+template<class Allocator = std::allocator<char>>
+class BasicPerfectHash {
+public:
+    typedef minicmd::String<Allocator> String;
+
+    explicit BasicPerfectHash(const Allocator& alloc = Allocator()) : keys(alloc), displacements(alloc), slots(alloc) {}
+
+    BasicPerfectHash(const BasicPerfectHash& other, const Allocator& alloc)
+        : keys(other.keys, alloc), displacements(other.displacements, alloc), slots(other.slots, alloc) {}
+
+    // duplicates map to their first occurrence
+    explicit BasicPerfectHash(Vector<Allocator, String> names)
+        : keys(std::move(names)), displacements(keys.get_allocator()), slots(keys.get_allocator()) {
+        if (keys.empty())
+            return;
+        Allocator alloc(keys.get_allocator());
+        size_t numKeys = keys.size();
+        Vector<Allocator, std::uint64_t> hashes(numKeys, 0, alloc);
+        Vector<Allocator, Vector<Allocator, std::uint32_t>> buckets(numKeys, Vector<Allocator, std::uint32_t>(alloc), alloc);
+        for (std::uint32_t i = 0; i < numKeys; ++i) {
+            hashes[i] = hashBytes(keys[i].data(), keys[i].size());
+            auto& bucket = buckets[hashes[i] % numKeys];
+            if (std::find_if(bucket.begin(), bucket.end(), [&](std::uint32_t k) { return keys[k] == keys[i]; }) == bucket.end())
+                bucket.push_back(i);
+        }
+        Vector<Allocator, std::uint32_t> order(numKeys, 0, alloc);
+        for (std::uint32_t b = 0; b < numKeys; ++b)
+            order[b] = b;
+        std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) { return buckets[a].size() > buckets[b].size(); });
+        displacements.assign(numKeys, 0);
+        slots.assign(numKeys + numKeys / 4 + 1, -1);
+        Vector<Allocator, size_t> placed(alloc);
+        for (std::uint32_t b : order) {  // the largest buckets first, while most slots are free
+            for (std::uint32_t displacement = 0; !buckets[b].empty(); ++displacement) {
+                placed.clear();
+                for (std::uint32_t k : buckets[b]) {
+                    size_t slot = slotOf(hashes[k], displacement);
+                    if (slots[slot] >= 0 || std::find(placed.begin(), placed.end(), slot) != placed.end())
+                        break;
+                    placed.push_back(slot);
                 }
+                if (placed.size() < buckets[b].size())
+                    continue;
+                for (size_t i = 0; i < placed.size(); ++i)
+                    slots[placed[i]] = static_cast<std::int32_t>(buckets[b][i]);
+                displacements[b] = displacement;
+                break;
             }
         }
     }
 
-    void addOptionGroup(OptionGroup group) {
-        optionGroups.push_back(group);
+    // index of the key, -1 if it isn't one of them
+    int find(ArgView key) const {
+        if (keys.empty())
+            return -1;
+        std::uint64_t hash = hashBytes(key.data, key.size);
+        std::int32_t i = slots[slotOf(hash, displacements[hash % keys.size()])];
+        return (i >= 0 && keys[i].size() == key.size && std::memcmp(keys[i].data(), key.data, key.size) == 0) ? i : -1;
     }
 
-    bool checkFlags() const {
-        bool valid = true;
-        for (auto& group : optionGroups) {
-            for (auto& o : group.options) {
-                valid = optionExists(o.first) || optionExists(o.second.second);
-                if (group.policy == Policy::required && !valid)
-                    break;
-                else if (group.policy == Policy::anyOf && valid)
-                    break;
-                else if (group.policy == Policy::optional)
-                    valid = true;  // don't care
-            }
-            if (!valid)
+    const Vector<Allocator, String>& names() const {
+        return keys;
+    }
+
+private:
+    size_t slotOf(std::uint64_t hash, std::uint32_t displacement) const {
+        return mixHash(hash + displacement * 0x9e3779b97f4a7c15ull) % slots.size();
+    }
+
+    Vector<Allocator, String> keys;
+    Vector<Allocator, std::uint32_t> displacements;  // of each bucket
+    Vector<Allocator, std::int32_t> slots;  // index of the key in each slot, or -1
+};
+
+typedef BasicPerfectHash<> PerfectHash;
+
+// view of a contiguous range of elements
+template<class Iterator>
+struct Range {
+    Iterator first;
+    Iterator last;
+    Iterator begin() const { return first; }
+    Iterator end() const { return last; }
+    size_t size() const { return static_cast<size_t>(last - first); }
+    bool empty() const { return first == last; }
+    auto operator[](size_t i) const -> decltype(*first) { return first[i]; }
+};
+
+// flag-like token, i.e. a dash followed by anything but a number
+inline bool looksLikeOption(ArgView token) {
+    return token.size > 1 && token.data[0] == '-' && !(token.data[1] >= '0' && token.data[1] <= '9') && token.data[1] != '.';
+}
+
+inline bool isLetter(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+// same as std::regex_match(arg, std::regex("^(-[a-zA-Z]{2,})(=.*$|$)"))
+inline bool isFlagCluster(ArgView arg) noexcept {
+    if (arg.size == 0 || arg.data[0] != '-')
+        return false;
+    size_t n = 1;
+    while (n < arg.size && isLetter(arg.data[n]))
+        ++n;
+    return n > 2 && (n == arg.size || arg.data[n] == '=');
+}
+
+// single letter flag split off a cluster like -xyz, viewed in static storage
+inline ArgView shortFlag(char letter) {
+    static const char flags[] =
+        "-a\0-b\0-c\0-d\0-e\0-f\0-g\0-h\0-i\0-j\0-k\0-l\0-m\0-n\0-o\0-p\0-q\0-r\0-s\0-t\0-u\0-v\0-w\0-x\0-y\0-z\0"
+        "-A\0-B\0-C\0-D\0-E\0-F\0-G\0-H\0-I\0-J\0-K\0-L\0-M\0-N\0-O\0-P\0-Q\0-R\0-S\0-T\0-U\0-V\0-W\0-X\0-Y\0-Z";
+    size_t offset = (letter >= 'a') ? 3 * (letter - 'a') : 3 * (26 + letter - 'A');
+    return ArgView(flags + offset, 2);
+}
+
+// splits an argv element into token views: -d=param into -d and param, -xyz into -x -y -z with unixFlags,
+// addToken(token, split) is told whether the token was split off before an =, e.g. the key of -D key=value
+template<class F>
+void splitArgument(ArgView arg, bool unixFlags, F addToken) {
+    if (unixFlags && isFlagCluster(arg)) {
+        for (size_t f=1; f < arg.size && arg.data[f-1] != '='; ++f)
+            addToken((arg.data[f] != '=') ? shortFlag(arg.data[f]) : ArgView(arg.data + f + 1, arg.size - f - 1), false);
+    } else {
+        const char* equal = static_cast<const char*>(std::memchr(arg.data, '=', arg.size));
+        if (equal == nullptr)
+            addToken(arg, false);
+        else {  // split argument with '='
+            addToken(ArgView(arg.data, equal - arg.data), true);
+            addToken(ArgView(equal + 1, arg.size - (equal + 1 - arg.data)), false);
+        }
+    }
+}
+
+inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\n';
+}
+
+// byte-wise order of views, the order of std::string
+inline bool viewLess(ArgView a, ArgView b) {
+    int order = std::memcmp(a.data, b.data, std::min(a.size, b.size));
+    return order < 0 || (order == 0 && a.size < b.size);
+}
+
+// whether the part is a view into the whole
+inline bool isWithin(ArgView part, ArgView whole) {
+    return !std::less<const char*>()(part.data, whole.data) && !std::less<const char*>()(whole.data + whole.size, part.data + part.size);
+}
+
+inline ArgView trim(ArgView str) {
+    while (str.size > 0 && (isBlank(str.data[0]) || str.data[0] == '\r'))
+        ++str.data, --str.size;
+    while (str.size > 0 && (isBlank(str.data[str.size - 1]) || str.data[str.size - 1] == '\r'))
+        --str.size;
+    return str;
+}
+
+// characters that end a run of literal characters outside of quotes
+inline bool isShellSpecial(char c) {
+    static const std::uint64_t specials[4] = {(1ull << ' ') | (1ull << '\t') | (1ull << '\n') | (1ull << '\'') | (1ull << '"'),
+                                              1ull << ('\\' - 64), 0, 0};
+    const unsigned char u = static_cast<unsigned char>(c);
+    return (specials[u >> 6] >> (u & 63)) & 1;
+}
+
+// position of the first special character in s[i, n), scans 8 bytes at a time as long as there is none
+inline size_t findShellSpecial(const char* s, size_t i, size_t n) {
+    const std::uint64_t ones = 0x0101010101010101ull;
+    const std::uint64_t highs = 0x8080808080808080ull;
+    for (; i + 8 <= n; i += 8) {
+        std::uint64_t chunk;
+        std::memcpy(&chunk, s + i, 8);
+        std::uint64_t found = 0;
+        for (unsigned char c : {' ', '\t', '\n', '\'', '"', '\\'}) {
+            const std::uint64_t x = chunk ^ (ones * c);  // zero bytes where chunk has c
+            found |= (x - ones) & ~x & highs;
+        }
+        if (found != 0)
+            break;
+    }
+    while (i < n && !isShellSpecial(s[i]))
+        ++i;
+    return i;
+}
+
+// splits a command line into words like a POSIX shell (quotes, escapes and whitespace, no expansions),
+// words without quotes or escapes are views into line, the others are unescaped into scratch,
+// returns Status::invalidQuoting for an unterminated quote or a trailing backslash
+template<class String, class F>
+Status splitCommandLine(ArgView line, String& scratch, F addWord) {
+    const char* s = line.data;
+    const size_t n = line.size;
+    size_t i = 0;
+    while (true) {
+        while (i < n && isBlank(s[i]))
+            ++i;
+        if (i == n)
+            return Status::ok;
+        const size_t start = i;
+        bool unescaped = false;  // the word is assembled in scratch
+        bool quoted = false;  // quotes make even an empty word a word
+        while (i < n && !isBlank(s[i])) {
+            const size_t run = i;
+            i = findShellSpecial(s, i, n);
+            if (unescaped)
+                scratch.append(s + run, i - run);
+            else if (i < n && !isBlank(s[i])) {
+                scratch.assign(s + start, i - start);
+                unescaped = true;
+            }
+            if (i == n || isBlank(s[i]))
                 break;
+            const char c = s[i++];
+            if (c == '\\') {
+                if (i == n)
+                    return Status::invalidQuoting;
+                if (s[i] != '\n')  // backslash newline is a line continuation
+                    scratch.push_back(s[i]);
+                ++i;
+            } else if (c == '\'') {
+                const char* close = static_cast<const char*>(std::memchr(s + i, '\'', n - i));
+                if (close == nullptr)
+                    return Status::invalidQuoting;
+                scratch.append(s + i, close - (s + i));
+                i = close - s + 1;
+                quoted = true;
+            } else {  // double quotes, backslash only escapes $ ` " \ and newline
+                while (true) {
+                    const size_t literal = i;
+                    while (i < n && s[i] != '"' && s[i] != '\\')
+                        ++i;
+                    scratch.append(s + literal, i - literal);
+                    if (i == n || (s[i] == '\\' && i + 1 == n))
+                        return Status::invalidQuoting;
+                    if (s[i++] == '"')
+                        break;
+                    const char e = s[i++];
+                    if (e != '$' && e != '`' && e != '"' && e != '\\' && e != '\n')
+                        scratch.push_back('\\');
+                    if (e != '\n')
+                        scratch.push_back(e);
+                }
+                quoted = true;
+            }
         }
-        return valid;
+        if (!unescaped)
+            addWord(ArgView(s + start, i - start));
+        else if (quoted || !scratch.empty())
+            addWord(ArgView(scratch.data(), scratch.size()));
     }
+}
 
-    void printHelpMessage(std::string title = "\nUSAGE") const {
-        std::cerr << title << std::endl;
-        for (auto& group : optionGroups) {
-            std::cerr << "\n[" + group.groupDescription + "]\n";
-            for (auto& o : group.options)
-                std::cerr << o.first << " " << o.second.second << "\t" << o.second.first << std::endl;
+}  // namespace minicmd
+
+// monotonic arena, e.g. to serve all memory of one parse and release it at once,
+// memory is handed out from the given buffer first and then from growing heap chunks
+class MonotonicArena {
+public:
+    explicit MonotonicArena(size_t chunkSize = 4096)
+        : buffer(nullptr), bufferSize(0), chunkSize(chunkSize), chunks(nullptr), current(nullptr), remaining(0),
+          sealed(false) {}
+    MonotonicArena(void* buffer, size_t size, size_t chunkSize = 4096)
+        : buffer(static_cast<char*>(buffer)), bufferSize(size), chunkSize(chunkSize),
+          chunks(nullptr), current(static_cast<char*>(buffer)), remaining(size), sealed(false) {}
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+    ~MonotonicArena() {
+        release();
+    }
+
+    void* allocate(size_t size, size_t alignment) {
+        if (sealed)
+            return ::operator new(size);
+        size_t padding = (alignment - reinterpret_cast<std::uintptr_t>(current) % alignment) % alignment;
+        if (current == nullptr || padding + size > remaining) {
+            addChunk(size + alignment);
+            padding = (alignment - reinterpret_cast<std::uintptr_t>(current) % alignment) % alignment;
         }
+        void* memory = current + padding;
+        current += padding + size;
+        remaining -= padding + size;
+        return memory;
     }
 
-    const std::string getParameter(const std::string& option) const {
-        auto itr = std::find(tokens.begin(), tokens.end(), option);
-        return (itr != tokens.end() && ++itr != tokens.end() && !isOption(*itr)) ? *itr : "";
+    // no-op for memory of the arena, only memory allocated while it was sealed is freed
+    void deallocate(void* memory) {
+        if (sealed && !contains(memory))
+            ::operator delete(memory);
     }
 
-    const std::vector<std::string> getMultiParameters(const std::string& option) const {
-        std::vector<std::string> params;
-        auto itr = std::find(tokens.begin(), tokens.end(), option);
-        while (itr != tokens.end() && ++itr != tokens.end() && !isOption(*itr)) {
-            params.push_back(*itr);
+    bool contains(const void* memory) const {
+        auto inside = [memory](const char* begin, size_t size) {
+            return std::less_equal<const void*>()(begin, memory) && std::less<const void*>()(memory, begin + size);
+        };
+        if (buffer != nullptr && inside(buffer, bufferSize))
+            return true;
+        for (const Chunk* chunk = chunks; chunk != nullptr; chunk = chunk->next) {
+            if (inside(reinterpret_cast<const char*>(chunk + 1), chunk->size))
+                return true;
         }
-        return params;
+        return false;
+    }
+
+    // frees all chunks at once, the arena can be reused afterwards
+    void release() {
+        while (chunks != nullptr) {
+            Chunk* next = chunks->next;
+            ::operator delete(chunks);
+            chunks = next;
+        }
+        current = buffer;
+        remaining = bufferSize;
+    }
+
+protected:
+    struct Chunk {
+        Chunk* next;
+        size_t size;
+    };
+
+    void addChunk(size_t minSize) {
+        size_t size = std::max(chunkSize, minSize);
+        chunkSize *= 2;
+        Chunk* chunk = static_cast<Chunk*>(::operator new(sizeof(Chunk) + size));
+        chunk->next = chunks;
+        chunk->size = size;
+        chunks = chunk;
+        current = reinterpret_cast<char*>(chunk + 1);
+        remaining = size;
+    }
+
+    char* buffer;
+    size_t bufferSize;
+    size_t chunkSize;
+    Chunk* chunks;
+    char* current;
+    size_t remaining;
+    bool sealed;  // allocations go to the heap, the arena isn't written anymore
+};
+
+// allocator drawing from a MonotonicArena, deallocation is a no-op
+template<class T>
+struct ArenaAllocator {
+    typedef T value_type;
+    MonotonicArena* arena;
+    ArenaAllocator(MonotonicArena& arena) : arena(&arena) {}
+    template<class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+    T* allocate(size_t n) {
+        return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T* memory, size_t) {
+        arena->deallocate(memory);
+    }
+};
+
+template<class T, class U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return a.arena == b.arena;
+}
+
+template<class T, class U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return a.arena != b.arena;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+// MonotonicArena in one anonymous mapping that can be made read-only, e.g. a frozen MiniCommander
+// before forking workers: the children share its pages instead of copying them on the first allocator write,
+// while sealed, allocations come from the heap and the arena isn't written anymore
+class SealableArena : public MonotonicArena {
+public:
+    explicit SealableArena(size_t capacity) : MonotonicArena(map(capacity), capacity) {
+        if (buffer == nullptr)
+            bufferSize = remaining = 0;  // mapping failed, falls back to heap chunks
+    }
+    ~SealableArena() {
+        if (buffer != nullptr)
+            munmap(buffer, bufferSize);
     }
 
-    bool optionExists(const std::string& option) const {
-        return std::find(tokens.begin(), tokens.end(), option) != tokens.end();
+    // makes the mapping read-only, returns false if it couldn't be protected
+    bool seal() {
+        sealed = true;
+        return buffer != nullptr && mprotect(buffer, bufferSize, PROT_READ) == 0;
+    }
+
+    bool unseal() {
+        sealed = false;
+        return buffer != nullptr && mprotect(buffer, bufferSize, PROT_READ | PROT_WRITE) == 0;
+    }
+
+    bool isSealed() const {
+        return sealed;
     }
 
 private:
-    bool isOption(const std::string& str) const {
-        for (auto& group : optionGroups) {
-            for (auto& o : group.options)
-                if (str==o.first || str==o.second.second || (unixFlags && str[0] == '-')) return true;
+    static void* map(size_t capacity) {
+        void* memory = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return memory != MAP_FAILED ? memory : nullptr;
+    }
+};
+#endif
+
+// default parameter of an option, either a value or a function producing it when it's queried the first time,
+// copies share the produced value, which comes from the allocator, a function is kept on the global heap
+template<class Allocator = std::allocator<char>>
+class BasicDefaultValue {
+public:
+    typedef minicmd::String<Allocator> String;
+
+    BasicDefaultValue() MINICMD_NOEXCEPT {}
+    BasicDefaultValue(const char* value, const Allocator& alloc = Allocator()) MINICMD_NOEXCEPT
+        : state(std::allocate_shared<State>(alloc, ArgView(value), alloc)) {}
+    BasicDefaultValue(const std::string& value, const Allocator& alloc = Allocator()) MINICMD_NOEXCEPT
+        : state(std::allocate_shared<State>(alloc, ArgView(value), alloc)) {}
+    template<class F, class = decltype(std::string(std::declval<F&>()()))>
+    BasicDefaultValue(F produce, const Allocator& alloc = Allocator()) MINICMD_NOEXCEPT
+        : state(std::allocate_shared<State>(alloc, std::function<std::string()>(produce), alloc)) {}
+
+    // copy whose value comes from alloc, it shares the value if that comes from an equal allocator already
+    BasicDefaultValue(const BasicDefaultValue& other, const Allocator& alloc) MINICMD_NOEXCEPT
+        : state(other.state == nullptr || other.state->value.get_allocator() == alloc
+                ? other.state : std::allocate_shared<State>(alloc, *other.state, alloc)) {}
+
+    bool exists() const MINICMD_NOEXCEPT {
+        return state != nullptr;
+    }
+
+    const String& get() const MINICMD_NOEXCEPT {
+        if (!state->evaluated) {
+            std::string produced = state->produce();
+            state->value.assign(produced.data(), produced.size());
+            state->evaluated = true;
+        }
+        return state->value;
+    }
+
+private:
+    struct State {
+        bool evaluated;
+        String value;
+        std::function<std::string()> produce;
+        State(ArgView value, const Allocator& alloc) : evaluated(true), value(value.data, value.size, alloc) {}
+        State(const std::function<std::string()>& produce, const Allocator& alloc)
+            : evaluated(false), value(alloc), produce(produce) {}
+        State(const State& other, const Allocator& alloc)
+            : evaluated(other.evaluated), value(other.value, alloc), produce(other.produce) {}
+    };
+
+    std::shared_ptr<State> state;
+};
+
+typedef BasicDefaultValue<> DefaultValue;
+
+// checks the parameters of an option, attached in BasicOptionGroup::addOption and run by checkFlags,
+// regexes and the perfect hash of choices are built once when the validator is created, copies share them,
+// the choices and the description come from the allocator, check functions and regexes from the global heap
+template<class Allocator = std::allocator<char>>
+class BasicValidator {
+public:
+    typedef minicmd::String<Allocator> String;
+
+    BasicValidator() MINICMD_NOEXCEPT {}
+    template<class F, class = decltype(bool(std::declval<F&>()(ArgView()))),
+             class = typename std::enable_if<!std::is_same<F, BasicValidator>::value>::type>
+    BasicValidator(F check, ArgView expected = "a valid value", const Allocator& alloc = Allocator()) MINICMD_NOEXCEPT
+        : state(std::allocate_shared<State>(alloc, std::function<bool(ArgView)>(check), expected, alloc)) {}
+
+    // copy whose choices and description come from alloc, it shares them if they come from an equal allocator already
+    BasicValidator(const BasicValidator& other, const Allocator& alloc) MINICMD_NOEXCEPT
+        : state(other.state == nullptr || other.state->expected.get_allocator() == alloc
+                ? other.state : std::allocate_shared<State>(alloc, *other.state, alloc)) {}
+
+    // one of the names, which map to their index, e.g. for --mode fast|safe
+    static BasicValidator choices(std::initializer_list<const char*> names, const Allocator& alloc = Allocator()) MINICMD_NOEXCEPT {
+        minicmd::Vector<Allocator, String> keys(alloc);
+        for (const char* name : names)
+            keys.push_back(String(name, alloc));
+        BasicValidator validator;
+        validator.state = std::allocate_shared<State>(alloc, std::function<bool(ArgView)>(), "one of ", alloc);
+        validator.state->choiceNames = minicmd::BasicPerfectHash<Allocator>(std::move(keys));
+        for (auto& name : validator.state->choiceNames.names())
+            validator.state->expected.append(&name == &validator.state->choiceNames.names().front() ? "" : "|").append(name);
+        return validator;
+    }
+
+#ifndef MINICMD_NO_EXCEPTIONS
+    // the whole value matches the ECMAScript regex, Status::invalidFormat if std::regex rejects it
+    static Expected<BasicValidator> pattern(const std::string& regex, const Allocator& alloc = Allocator()) {
+        std::shared_ptr<const std::regex> compiled;
+        try {
+            compiled = std::make_shared<const std::regex>(regex);
+        } catch (const std::regex_error&) {
+            return Expected<BasicValidator>{BasicValidator(), Status::invalidFormat};
+        }
+        String expected("a value matching ", alloc);
+        expected.append(regex.data(), regex.size());
+        return Expected<BasicValidator>{BasicValidator([compiled](ArgView value) {
+            return std::regex_match(value.data, value.data + value.size, *compiled);
+        }, expected, alloc), Status::ok};
+    }
+#else
+    // std::regex can only report an invalid pattern by throwing, so patterns need exceptions
+    template<class Regex>
+    static Expected<BasicValidator> pattern(const Regex&, const Allocator& = Allocator()) noexcept {
+        static_assert(sizeof(Regex) == 0, "Validator::pattern isn't available without exceptions");
+        return Expected<BasicValidator>{BasicValidator(), Status::invalidFormat};
+    }
+#endif
+
+    // a number between min and max, inclusive
+    static BasicValidator range(double min, double max, const Allocator& alloc = Allocator()) MINICMD_NOEXCEPT {
+        String expected("a number between ", alloc);
+        appendNumber(expected, min);
+        expected.append(" and ");
+        appendNumber(expected, max);
+        return BasicValidator([min, max](ArgView value) {
+            std::string text(value);  // null-terminated for strtod
+            char* end = nullptr;
+            double number = std::strtod(text.c_str(), &end);
+            return !text.empty() && end == text.c_str() + text.size() && number >= min && number <= max;
+        }, expected, alloc);
+    }
+
+    bool exists() const MINICMD_NOEXCEPT {
+        return state != nullptr && (!state->choiceNames.names().empty() || state->check);
+    }
+
+    bool operator()(ArgView value) const MINICMD_NOEXCEPT {
+        if (state == nullptr)
+            return true;
+        return state->check ? state->check(value) : (state->choiceNames.names().empty() || state->choiceNames.find(value) >= 0);
+    }
+
+    // index of the choice, -1 if the value isn't one of them
+    int choice(ArgView value) const MINICMD_NOEXCEPT {
+        return state != nullptr ? state->choiceNames.find(value) : -1;
+    }
+
+    // description of the valid values for error messages
+    ArgView expectation() const MINICMD_NOEXCEPT {
+        return state != nullptr ? ArgView(state->expected) : ArgView();
+    }
+
+private:
+    struct State {
+        std::function<bool(ArgView)> check;
+        minicmd::BasicPerfectHash<Allocator> choiceNames;
+        String expected;
+        State(const std::function<bool(ArgView)>& check, ArgView expected, const Allocator& alloc)
+            : check(check), choiceNames(alloc), expected(expected.data, expected.size, alloc) {}
+        State(const State& other, const Allocator& alloc)
+            : check(other.check), choiceNames(other.choiceNames, alloc), expected(other.expected, alloc) {}
+    };
+
+    static void appendNumber(String& text, double number) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%g", number);
+        text.append(buffer);
+    }
+
+    std::shared_ptr<State> state;
+};
+
+typedef BasicValidator<> Validator;
+
+// arguments for exec'ing another program, e.g. the ones a wrapper doesn't consume itself, which can be
+// added, removed or rewritten, argv() returns a null-terminated array whose copied arguments share one buffer
+template<class Allocator = std::allocator<char>>
+class BasicArgvBuilder {
+public:
+    explicit BasicArgvBuilder(const Allocator& alloc = Allocator()) MINICMD_NOEXCEPT
+        : args(alloc), storage(alloc), pointers(alloc) {}
+
+    BasicArgvBuilder(const BasicArgvBuilder& other, const Allocator& alloc) MINICMD_NOEXCEPT
+        : args(other.args, alloc), storage(other.storage, alloc), pointers(alloc) {}
+
+    // copies the argument into the buffer
+    BasicArgvBuilder& add(ArgView arg) MINICMD_NOEXCEPT {
+        args.push_back(Arg{nullptr, storage.size()});
+        storage.append(arg.data, arg.size);
+        storage.push_back('\0');
+        return *this;
+    }
+
+    // reuses the pointer, the argument has to outlive the builder, like the elements of argv
+    BasicArgvBuilder& addBorrowed(const char* arg) MINICMD_NOEXCEPT {
+        args.push_back(Arg{arg, 0});
+        return *this;
+    }
+
+    // removes every occurrence of arg together with the given number of following arguments
+    BasicArgvBuilder& remove(ArgView arg, size_t numParams = 0) MINICMD_NOEXCEPT {
+        size_t kept = 0;
+        for (size_t i = 0; i < args.size(); ++i) {
+            if (arg == get(i))
+                i += numParams;
+            else
+                args[kept++] = args[i];
+        }
+        args.resize(kept);
+        return *this;
+    }
+
+    // replaces every occurrence of arg
+    BasicArgvBuilder& rewrite(ArgView arg, ArgView replacement) MINICMD_NOEXCEPT {
+        for (size_t i = 0; i < args.size(); ++i) {
+            if (arg == get(i)) {
+                args[i] = Arg{nullptr, storage.size()};
+                storage.append(replacement.data, replacement.size);
+                storage.push_back('\0');
+            }
+        }
+        return *this;
+    }
+
+    size_t size() const MINICMD_NOEXCEPT {
+        return args.size();
+    }
+
+    const char* get(size_t i) const MINICMD_NOEXCEPT {
+        return args[i].borrowed ? args[i].borrowed : storage.data() + args[i].offset;
+    }
+
+    // null-terminated array for execv and friends, valid until the builder is modified
+    char* const* argv() MINICMD_NOEXCEPT {
+        pointers.resize(args.size() + 1);
+        for (size_t i = 0; i < args.size(); ++i)
+            pointers[i] = const_cast<char*>(get(i));
+        pointers[args.size()] = nullptr;
+        return pointers.data();
+    }
+
+private:
+    struct Arg {
+        const char* borrowed;  // nullptr if the argument is copied
+        size_t offset;  // in storage
+    };
+
+    minicmd::Vector<Allocator, Arg> args;
+    minicmd::String<Allocator> storage;
+    minicmd::Vector<Allocator, char*> pointers;
+};
+
+typedef BasicArgvBuilder<> ArgvBuilder;
+
+namespace minicmd {
+
+inline bool parseValue(const char* str, bool& value) {
+    value = std::strcmp(str, "false") != 0 && std::strcmp(str, "0") != 0;
+    return true;
+}
+
+inline bool parseValue(const char* str, std::string& value) {
+    value = str;
+    return true;
+}
+
+template<class T>
+typename std::enable_if<std::is_integral<T>::value, bool>::type parseValue(const char* str, T& value) {
+    char* end;
+    long long number = std::strtoll(str, &end, 0);
+    if (end == str || *end != '\0')
+        return false;
+    value = static_cast<T>(number);
+    return true;
+}
+
+template<class T>
+typename std::enable_if<std::is_floating_point<T>::value, bool>::type parseValue(const char* str, T& value) {
+    char* end;
+    double number = std::strtod(str, &end);
+    if (end == str || *end != '\0')
+        return false;
+    value = static_cast<T>(number);
+    return true;
+}
+
+}  // namespace minicmd
+
+// option registered with MINICMD_FLAG in any translation unit, registration happens during static
+// initialization by linking into a list whose head is constant-initialized, so needs no locks
+class RegisteredOption {
+public:
+    const char* flag;
+    const char* description;
+    const RegisteredOption* next;
+
+    RegisteredOption(const char* flag, const char* description) noexcept
+        : flag(flag), description(description), next(first()) {
+        first() = this;
+    }
+
+    // sets the value from the parameter, false if it couldn't be parsed
+    virtual bool assign(const char* parameter) const = 0;
+
+    static const RegisteredOption*& first() noexcept {
+        static const RegisteredOption* head = nullptr;
+        return head;
+    }
+
+protected:
+    ~RegisteredOption() {}
+};
+
+template<class T>
+class RegisteredFlag : public RegisteredOption {
+public:
+    RegisteredFlag(T& value, const char* flag, const char* description) noexcept
+        : RegisteredOption(flag, description), value(value) {}
+
+    bool assign(const char* parameter) const override {
+        return minicmd::parseValue(parameter, value);
+    }
+
+private:
+    T& value;
+};
+
+// defines the global FLAG_name of type bool, std::string, an integer or floating point type,
+// set by MiniCommander::applyRegisteredOptions if the flag is given, defaultValue otherwise
+#define MINICMD_FLAG(type, name, flag, defaultValue, description) \
+    type FLAG_##name = defaultValue; \
+    static const RegisteredFlag<type> minicmdRegisteredFlag_##name(FLAG_##name, flag, description)
+
+// declares FLAG_name defined with MINICMD_FLAG in another translation unit
+#define MINICMD_DECLARE_FLAG(type, name) extern type FLAG_##name
+
+template<class Allocator = std::allocator<char>>
+struct BasicOptionGroup {
+    typedef minicmd::String<Allocator> String;
+    typedef BasicDefaultValue<Allocator> DefaultValue;
+    typedef BasicValidator<Allocator> Validator;
+    Policy policy;
+    String groupDescription;
+    minicmd::Map<Allocator, String, std::pair<String, String>> options;
+    minicmd::Map<Allocator, String, DefaultValue> defaults;
+    minicmd::Map<Allocator, String, String> environmentVariables;
+    minicmd::Map<Allocator, String, Arity> arities;
+    minicmd::Map<Allocator, String, Validator> validators;
+    minicmd::Vector<Allocator, std::pair<String, String>> requirements;  // flag -> flag it requires
+    minicmd::Vector<Allocator, std::pair<String, String>> conflicts;
+    minicmd::Vector<Allocator, String> mapOptions;
+    BasicOptionGroup(Policy p, ArgView description, const Allocator& alloc = Allocator()) MINICMD_NOEXCEPT
+        : policy(p), groupDescription(description.data, description.size, alloc),
+          options(std::less<String>(), alloc), defaults(std::less<String>(), alloc),
+          environmentVariables(std::less<String>(), alloc), arities(std::less<String>(), alloc),
+          validators(std::less<String>(), alloc), requirements(alloc), conflicts(alloc),
+          mapOptions(alloc) {}
+
+    // copy whose memory comes from alloc, defaults and validators share their values if they come from it already
+    BasicOptionGroup(const BasicOptionGroup& other, const Allocator& alloc) MINICMD_NOEXCEPT
+        : policy(other.policy), groupDescription(other.groupDescription, alloc),
+          options(std::less<String>(), alloc), defaults(std::less<String>(), alloc),
+          environmentVariables(other.environmentVariables, alloc), arities(other.arities, alloc),
+          validators(std::less<String>(), alloc), requirements(other.requirements, alloc),
+          conflicts(other.conflicts, alloc), mapOptions(other.mapOptions, alloc) {
+        for (auto& o : other.options)  // the nested pairs wouldn't get the allocator from a copy of the map
+            options.emplace(String(o.first, alloc), std::make_pair(String(o.second.first, alloc), String(o.second.second, alloc)));
+        for (auto& d : other.defaults)
+            defaults.insert(std::make_pair(String(d.first, alloc), DefaultValue(d.second, alloc)));
+        for (auto& v : other.validators)
+            validators.insert(std::make_pair(String(v.first, alloc), Validator(v.second, alloc)));
+    }
+
+    void addOption(ArgView flag, ArgView desc = ArgView(), ArgView alternativeFlag = ArgView(),
+                   const DefaultValue& defaultValue = DefaultValue(), const Validator& validator = Validator()) MINICMD_NOEXCEPT {
+        String key = str(flag);
+        auto option = std::make_pair(str(desc), str(alternativeFlag));
+        auto itr = options.find(key);
+        if (itr != options.end())
+            itr->second = option;
+        else
+            options.emplace(key, std::move(option));
+        defaults.erase(key);
+        if (defaultValue.exists())
+            defaults.emplace(key, DefaultValue(defaultValue, groupDescription.get_allocator()));
+        validators.erase(key);
+        if (validator.exists())
+            validators.emplace(key, Validator(validator, groupDescription.get_allocator()));
+        mapOptions.erase(std::remove(mapOptions.begin(), mapOptions.end(), key), mapOptions.end());
+    }
+
+    // the key=value parameters of all occurrences of the option are collected into a map, e.g. for -D name=value,
+    // the last value of a key wins, a parameter without = is a key with an empty value
+    void addMapOption(ArgView flag, ArgView desc = ArgView(), ArgView alternativeFlag = ArgView()) MINICMD_NOEXCEPT {
+        addOption(flag, desc, alternativeFlag);
+        mapOptions.push_back(str(flag));
+    }
+
+    // the option falls back to the environment variable if it's not given, e.g. -j to MYTOOL_JOBS,
+    // the option can be given by its flag or alternative, bindings of flags that aren't declared are ignored
+    void addEnvironmentVariable(ArgView flag, ArgView variable) MINICMD_NOEXCEPT {
+        String key = str(flag);
+        for (auto& o : options) {
+            if (o.second.second == key)
+                key = o.first;  // bound by the alternative
+        }
+        environmentVariables.erase(key);
+        environmentVariables.emplace(key, str(variable));
+    }
+
+    // the option can only be given together with the other one, which may belong to another group
+    void addRequirement(ArgView flag, ArgView requiredFlag) MINICMD_NOEXCEPT {
+        requirements.push_back(std::make_pair(str(flag), str(requiredFlag)));
+    }
+
+    // the options can't be given together, the other one may belong to another group
+    void addConflict(ArgView flag, ArgView conflictingFlag) MINICMD_NOEXCEPT {
+        conflicts.push_back(std::make_pair(str(flag), str(conflictingFlag)));
+    }
+
+    // the option takes that many parameters, also tokens starting with - that aren't declared flags,
+    // e.g. Arity::exactly(2) for --range -5 5, tokens after them are positional arguments
+    void setArity(ArgView flag, Arity arity) MINICMD_NOEXCEPT {
+        String key = str(flag);
+        arities.erase(key);
+        arities.emplace(key, arity);
+    }
+
+private:
+    String str(ArgView view) const {
+        return String(view.data, view.size, groupDescription.get_allocator());
+    }
+};
+
+typedef BasicOptionGroup<> OptionGroup;
+
+// all memory of a BasicMiniCommander, including query results, comes from its allocator
+template<class Allocator = std::allocator<char>>
+class BasicMiniCommander {
+public:
+    typedef minicmd::String<Allocator> String;
+    typedef minicmd::Vector<Allocator, String> StringVector;
+    typedef BasicDefaultValue<Allocator> DefaultValue;
+    typedef BasicValidator<Allocator> Validator;
+    typedef BasicArgvBuilder<Allocator> ArgvBuilder;
+
+    // lazy: tokenize argv only as far as queries need it, argv must outlive the MiniCommander then
+    BasicMiniCommander(const int argc, char const*const* argv, bool unixFlags=false, bool lazy=false,
+                       const Allocator& alloc = Allocator()) MINICMD_NOEXCEPT
+        : unixFlags(unixFlags), argc(argc), argv(argv), nextArg(1), alloc(alloc), state(Status::ok),
+          text(alloc), tokens(alloc), tokenHashes(alloc), splitTokens(alloc), tokenOrigins(alloc), indexSlots(alloc), numIndexed(0), sortedIndex(Token{nullptr, 0, 0}),
+          subcommands(std::less<String>(), alloc), invokedSubcommand(alloc),
+          environmentIndexed(false), environmentIndex(0, minicmd::StringHash(), std::equal_to<String>(), alloc),
+          schema(std::allocate_shared<Schema>(alloc, alloc)), schemaDirty(true),
+          abbreviations(false), ambiguousAbbreviation(false),
+          strict(false), allowPositionals(false), kinds(alloc), numUnknown(0), 
+          numParameters(alloc), positionals(alloc), classification(Classification{npos, -1, true}),
+          mapEntries(alloc), numMapEntries(0),
+          operandsBegin(npos), operandsEnd(0) {
+        if (!lazy) {
+            while (tokenizeNext()) {}
+            tokenOrigins.clear();  // argv doesn't need to outlive an eager MiniCommander, so nothing borrows from it
+        }
+    }
+
+    // splits a single command line string like a POSIX shell, the first word is the program name
+    explicit BasicMiniCommander(ArgView commandLine, bool unixFlags=false,
+                                const Allocator& alloc = Allocator()) MINICMD_NOEXCEPT
+        : unixFlags(unixFlags), argc(0), argv(nullptr), nextArg(1), alloc(alloc), state(Status::ok),
+          text(alloc), tokens(alloc), tokenHashes(alloc), splitTokens(alloc), tokenOrigins(alloc), indexSlots(alloc), numIndexed(0), sortedIndex(Token{nullptr, 0, 0}),
+          subcommands(std::less<String>(), alloc), invokedSubcommand(alloc),
+          environmentIndexed(false), environmentIndex(0, minicmd::StringHash(), std::equal_to<String>(), alloc),
+          schema(std::allocate_shared<Schema>(alloc, alloc)), schemaDirty(true),
+          abbreviations(false), ambiguousAbbreviation(false),
+          strict(false), allowPositionals(false), kinds(alloc), numUnknown(0), 
+          numParameters(alloc), positionals(alloc), classification(Classification{npos, -1, true}),
+          mapEntries(alloc), numMapEntries(0),
+          operandsBegin(npos), operandsEnd(0) {
+        text.assign(commandLine.data, commandLine.size);  // plain words are tokens in place
+        text.push_back('\0');
+        String scratch(alloc);
+        bool program = true;
+        state = minicmd::splitCommandLine(commandLine, scratch, [&](ArgView word) {
+            if (!program)  // words with quotes or escapes are unescaped in scratch and copied
+                addArgument(word, minicmd::isWithin(word, commandLine) ? word.data - commandLine.data : npos);
+            program = false;
+        });
+    }
+
+    // copies take their memory from the same allocator, unlike the containers they're made of
+    BasicMiniCommander(const BasicMiniCommander& other) MINICMD_NOEXCEPT : BasicMiniCommander(other, other.alloc) {}
+
+    // copy whose memory comes from alloc, it shares the compiled option groups if they come from an equal allocator
+    BasicMiniCommander(const BasicMiniCommander& other, const Allocator& alloc) MINICMD_NOEXCEPT
+        : unixFlags(other.unixFlags), argc(other.argc), argv(other.argv), nextArg(other.nextArg), alloc(alloc), state(other.state),
+          text(other.text, alloc), tokens(other.tokens, alloc), tokenHashes(other.tokenHashes, alloc),
+          splitTokens(other.splitTokens, alloc), tokenOrigins(other.tokenOrigins, alloc), indexSlots(other.indexSlots, alloc),
+          numIndexed(other.numIndexed), sortedIndex(other.sortedIndex),
+          subcommands(other.subcommands, alloc), invokedSubcommand(other.invokedSubcommand, alloc),
+          environmentIndexed(other.environmentIndexed), environmentIndex(other.environmentIndex, alloc),
+          schema(other.alloc == alloc ? other.schema : std::allocate_shared<Schema>(alloc, *other.schema, alloc)),
+          schemaDirty(other.schemaDirty), abbreviations(other.abbreviations), ambiguousAbbreviation(other.ambiguousAbbreviation),
+          strict(other.strict), allowPositionals(other.allowPositionals), kinds(other.kinds, alloc), numUnknown(other.numUnknown),
+          numParameters(other.numParameters, alloc), positionals(other.positionals, alloc), classification(other.classification),
+          mapEntries(other.mapEntries, alloc), numMapEntries(other.numMapEntries),
+          operandsBegin(other.operandsBegin), operandsEnd(other.operandsEnd) {}
+
+    BasicMiniCommander(BasicMiniCommander&&) = default;
+    BasicMiniCommander& operator=(const BasicMiniCommander&) = default;
+    BasicMiniCommander& operator=(BasicMiniCommander&&) = default;
+
+    // Status::invalidQuoting if the command line couldn't be split completely,
+    // Status::ambiguousOption if an abbreviation matches several long options,
+    // Status::missingParameter if an option is given with fewer parameters than its arity
+    Status status() const MINICMD_NOEXCEPT {
+        if (abbreviations || strict)
+            compileOptions();
+        if (state == Status::ok && ambiguousAbbreviation)
+            return Status::ambiguousOption;
+        if (state == Status::ok && strict) {
+            while (tokenizeNext()) {}
+            classifyTokens();
+            size_t subcommand = invokedSubcommand.empty() ? 0 : 1;
+            if (numUnknown > 0)
+                return Status::unknownOption;
+            if (!allowPositionals && positionals.size() > subcommand)
+                return Status::unexpectedArgument;
         }
+        if (state == Status::ok && declaresArities()) {  // fewer parameters than an option's minimum
+            tokenKinds();
+            for (size_t pos = 0; pos < tokens.size(); ++pos) {
+                std::int32_t option = kinds[pos] == TokenKind::flag ? matchOption(tokenAt(pos)) : -1;
+                if (option >= 0 && schema->optionArities[option].first && numParameters[pos] < schema->optionArities[option].second.min)
+                    return Status::missingParameter;
+            }
+        }
+        return state;
+    }
+
+    // in strict mode, status() reports unknown options as Status::unknownOption and, unless they're
+    // allowed, positional arguments other than the subcommand as Status::unexpectedArgument
+    void setStrict(bool enable, bool allowPositionals = false) MINICMD_NOEXCEPT {
+        strict = enable;
+        this->allowPositionals = allowPositionals;
+    }
+
+    // number of positional arguments, i.e. the ones before the first flag, the ones after
+    // the parameters of an option with an arity and the operands after --
+    size_t numPositionals() const MINICMD_NOEXCEPT {
+        tokenKinds();
+        return positionals.size();
+    }
+
+    // positional argument in constant time, in the order they're given
+    ArgView positional(size_t i) const MINICMD_NOEXCEPT {
+        tokenKinds();
+        return tokenAt(positionals[i]);
+    }
+
+    // views of consecutive tokens, valid until tokens are added
+    class TokenIterator {
+    public:
+        TokenIterator(const BasicMiniCommander* commander, size_t pos) : commander(commander), pos(pos) {}
+        ArgView operator*() const { return commander->tokenAt(pos); }
+        ArgView operator[](size_t i) const { return commander->tokenAt(pos + i); }
+        TokenIterator& operator++() { ++pos; return *this; }
+        std::ptrdiff_t operator-(const TokenIterator& other) const { return pos - other.pos; }
+        bool operator==(const TokenIterator& other) const { return pos == other.pos; }
+        bool operator!=(const TokenIterator& other) const { return pos != other.pos; }
+
+    private:
+        const BasicMiniCommander* commander;
+        size_t pos;
+    };
+
+    // arguments after the -- terminator as they are, e.g. a file named -x
+    minicmd::Range<TokenIterator> operands() const MINICMD_NOEXCEPT {
+        while (tokenizeNext()) {}
+        if (operandsBegin == npos)
+            return {TokenIterator(this, 0), TokenIterator(this, 0)};
+        return {TokenIterator(this, operandsBegin), TokenIterator(this, operandsEnd)};
+    }
+
+    // classification of all tokens, which the queries reuse
+    const minicmd::Vector<Allocator, TokenKind>& tokenKinds() const MINICMD_NOEXCEPT {
+        while (tokenizeNext()) {}
+        classifyTokens();
+        return kinds;
+    }
+
+    // lets unambiguous prefixes of long options stand for them, e.g. --verb for --verbose like getopt_long,
+    // the arguments are tokenized completely when the options are compiled and abbreviations are replaced
+    void setAbbreviations(bool enable) MINICMD_NOEXCEPT {
+        abbreviations = enable;
+        schemaDirty = true;
+    }
+
+    // builds a MiniCommander from a file with null-separated arguments like /proc/<pid>/cmdline,
+    // the first one is the program name, status() is Status::cannotReadFile if the file couldn't be read
+    static BasicMiniCommander fromCmdlineFile(ArgView path, bool unixFlags=false,
+                                              const Allocator& alloc = Allocator()) MINICMD_NOEXCEPT {
+        BasicMiniCommander cmd(ArgView(), unixFlags, alloc);
+        String arguments(alloc);
+        if (readFile(path, arguments))
+            cmd.tokenizeArgumentList(ArgView(arguments.data(), arguments.size()));
+        else
+            cmd.state = Status::cannotReadFile;
+        return cmd;
+    }
+
+    // arguments of a running process, read from /proc/<pid>/cmdline, pid 0 for the own process
+    static BasicMiniCommander fromProcess(long pid = 0, bool unixFlags=false,
+                                          const Allocator& alloc = Allocator()) MINICMD_NOEXCEPT {
+        char path[64];
+        if (pid == 0)
+            std::snprintf(path, sizeof(path), "/proc/self/cmdline");
+        else
+            std::snprintf(path, sizeof(path), "/proc/%ld/cmdline", pid);
+        return fromCmdlineFile(path, unixFlags, alloc);
+    }
+
+#ifdef __linux__
+    // builds a MiniCommander for each process in procRoot with the option groups and collects classify(cmd) with
+    // the pid, in parallel on the given number of threads (0: all cores), the option groups are compiled and their
+    // defaults evaluated once, all MiniCommanders share them read-only, processes that exit during the scan are
+    // skipped, the results are ordered by pid
+    template<class Groups, class Classify>
+    static auto scanProcesses(const Groups& groups, Classify classify, ArgView procRoot = "/proc", unsigned threads = 0)
+        -> std::vector<std::pair<long, decltype(classify(std::declval<const BasicMiniCommander&>()))>> {
+        typedef std::pair<long, decltype(classify(std::declval<const BasicMiniCommander&>()))> Result;
+        std::string root(procRoot.data, procRoot.size);
+        std::vector<long> pids;
+        if (DIR* dir = opendir(root.c_str())) {
+            while (dirent* entry = readdir(dir)) {
+                char* end;
+                long pid = std::strtol(entry->d_name, &end, 10);
+                if (end != entry->d_name && *end == '\0')
+                    pids.push_back(pid);
+            }
+            closedir(dir);
+        }
+        BasicMiniCommander prototype((ArgView()));
+        for (auto& group : groups)
+            prototype.addOptionGroup(group);
+        prototype.freeze();
+        threads = (threads > 0) ? threads : std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::vector<Result>> results(threads);
+        std::atomic<size_t> next(0);
+        auto scan = [&](unsigned thread) {
+            for (size_t i = next++; i < pids.size(); i = next++) {
+                BasicMiniCommander cmd = fromCmdlineFile(root + "/" + std::to_string(pids[i]) + "/cmdline");
+                if (cmd.status() != Status::ok)
+                    continue;
+                cmd.schema = prototype.schema;
+                cmd.schemaDirty = true;
+                results[thread].push_back(Result(pids[i], classify(static_cast<const BasicMiniCommander&>(cmd))));
+            }
+        };
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < threads; ++t)
+            pool.push_back(std::thread(scan, t));
+        scan(0);
+        for (auto& thread : pool)
+            thread.join();
+        std::vector<Result> merged;
+        for (auto& r : results)
+            merged.insert(merged.end(), r.begin(), r.end());
+        std::sort(merged.begin(), merged.end(), [](const Result& a, const Result& b) { return a.first < b.first; });
+        return merged;
+    }
+#endif
+
+    // maps a regular file read-only and merges it with loadConfig, other files are read at once
+    Status loadConfigFile(ArgView path) MINICMD_NOEXCEPT {
+        String config(alloc);
+#if defined(__unix__) || defined(__APPLE__)
+        config.assign(path.data, path.size);
+        int file = open(config.c_str(), O_RDONLY);
+        if (file < 0)
+            return Status::cannotReadFile;
+        struct stat info;
+        size_t size = (fstat(file, &info) == 0 && S_ISREG(info.st_mode)) ? size_t(info.st_size) : 0;
+        void* mapped = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0) : MAP_FAILED;
+        close(file);
+        if (mapped != MAP_FAILED) {  // the values are copied to the tokens, so it's unmapped right away
+            Status result = loadConfig(ArgView(static_cast<const char*>(mapped), size));
+            munmap(mapped, size);
+            return result;
+        }
+        config.clear();
+#endif
+        return readFile(path, config) ? loadConfig(config) : Status::cannotReadFile;
+    }
+
+    // merges options from an INI-style config with lines "key = value", "key" for flags and "[section]",
+    // which prefixes the following keys with "section.", and comment lines starting with # or ;.
+    // A key names an option by its flag or alternative without leading dashes, the value is split like
+    // a command line string, if a key is repeated its last line wins. Options given on the command line or by
+    // environment variables take precedence, so option groups must be added first. Returns Status::unknownOption if keys didn't name any option.
+    Status loadConfig(ArgView config) MINICMD_NOEXCEPT {
+        while (tokenizeNext()) {}
+        minicmd::Map<Allocator, String, const String*> keys(std::less<String>(), alloc);  // key -> flag
+        for (auto& group : schema->optionGroups) {
+            for (auto& o : group.options) {
+                keys.insert(std::make_pair(configKey(o.first), &o.first));
+                if (!o.second.second.empty())
+                    keys.insert(std::make_pair(configKey(o.second.second), &o.first));
+            }
+        }
+        struct Setting {
+            const String* flag;
+            bool hasValue;
+            ArgView value;
+        };
+        minicmd::Vector<Allocator, Setting> settings(alloc);  // in the order the options first appear
+        minicmd::Map<Allocator, const String*, size_t> settingOf(std::less<const String*>(), alloc);
+        Status result = Status::ok;
+        String section(alloc), key(alloc), scratch(alloc);
+        const char* end = config.data + config.size;
+        for (const char* line = config.data; line < end; ) {
+            const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', end - line));
+            lineEnd = lineEnd ? lineEnd : end;
+            ArgView text = minicmd::trim(ArgView(line, lineEnd - line));
+            line = lineEnd + 1;
+            if (text.empty() || text.data[0] == '#' || text.data[0] == ';')
+                continue;
+            if (text.data[0] == '[' && text.data[text.size - 1] == ']') {
+                section.assign(text.data + 1, text.size - 2);
+                continue;
+            }
+            const char* equal = static_cast<const char*>(std::memchr(text.data, '=', text.size));
+            ArgView name = minicmd::trim(ArgView(text.data, equal ? equal - text.data : text.size));
+            key.assign(section);
+            if (!section.empty())
+                key.push_back('.');
+            key.append(name.data, name.size);
+            auto option = keys.find(key);
+            if (option == keys.end()) {
+                result = (result == Status::ok) ? Status::unknownOption : result;
+                continue;
+            }
+            auto known = settingOf.insert(std::make_pair(option->second, settings.size()));
+            if (known.second)
+                settings.push_back(Setting{option->second, false, ArgView()});
+            Setting& setting = settings[known.first->second];  // the last line of a repeated key wins
+            setting.hasValue = equal != nullptr;
+            if (equal != nullptr)
+                setting.value = minicmd::trim(ArgView(equal + 1, text.data + text.size - equal - 1));
+        }
+        for (auto& setting : settings) {
+            const String& flag = *setting.flag;
+            const String& alternative = optionOf(flag)->second.second;
+            if (optionExists(flag) || (!alternative.empty() && optionExists(alternative)))
+                continue;
+            addToken(flag);
+            if (setting.hasValue) {
+                ArgView value = setting.value;
+                Status split = minicmd::splitCommandLine(value, scratch, [this](ArgView word) { addToken(word); });
+                result = (result == Status::ok) ? split : result;
+            }
+        }
+        return result;
+    }
+
+    // a flag ending with * declares a prefix family like -I* or -Wno-*, whose members carry a joined
+    // value like -I/usr/include, or take it from the next argument like -I /usr/include
+    void addOptionGroup(const BasicOptionGroup<Allocator>& group) MINICMD_NOEXCEPT {
+        if (schema.use_count() > 1)  // shared with copies
+            schema = std::allocate_shared<Schema>(alloc, *schema, alloc);
+        schema->optionGroups.emplace_back(group, alloc);
+        schema->compiled = false;
+        schemaDirty = true;
+    }
+
+    // registers a subcommand that is invoked by giving its name as first argument,
+    // buildOptions(*this) adds its option groups and is only called if it's the invoked one
+    template<class F>
+    void addSubcommand(ArgView name, F buildOptions, ArgView description = ArgView()) MINICMD_NOEXCEPT {
+        String key(name.data, name.size, alloc);
+        bool known = subcommands.count(key) > 0;
+        subcommands.emplace(key, String(description.data, description.size, alloc));
+        bool invoked = invokedSubcommand.empty() ? hasToken(0) && !isOperand(0) && tokenAt(0) == key :
+                                                   invokedSubcommand == key && !known;  // restored by deserialize
+        if (invoked) {
+            invokedSubcommand = key;
+            buildOptions(*this);
+        }
+    }
+
+    // name of the invoked subcommand, empty if there is none
+    const String& subcommand() const MINICMD_NOEXCEPT {
+        return invokedSubcommand;
+    }
+
+    // prints every failed policy and invalid parameter to std::cerr and returns false if there are any
+    bool checkFlags() const MINICMD_NOEXCEPT {
+        StringVector errors = validationErrors();
+        for (auto& error : errors)
+            std::cerr << error << std::endl;
+        return errors.empty();
+    }
+
+    // every failed policy, requirement, conflict and parameter rejected by its validator, checked in one pass
+    // over the option groups that records the given options in a bitset, then each requirement or conflict
+    // between options is a test of two bits
+    const StringVector validationErrors() const MINICMD_NOEXCEPT {
+        compileOptions();
+        StringVector errors(alloc);
+        auto error = [&](std::initializer_list<ArgView> parts) {
+            errors.push_back(String(alloc));
+            for (auto& part : parts)
+                errors.back().append(part.data, part.size);
+        };
+        minicmd::Vector<Allocator, std::uint64_t> givenBits(schema->optionArities.size() / 64 + 1, 0, alloc);
+        auto isGiven = [&](std::int32_t option) { return ((givenBits[option / 64] >> (option % 64)) & 1) != 0; };
+        std::int32_t option = 0;
+        for (auto& group : schema->optionGroups) {
+            size_t numGiven = 0;
+            for (auto& o : group.options) {
+                const String& alternative = o.second.second;
+                bool given = optionExists(o.first) || (!alternative.empty() && optionExists(alternative));
+                givenBits[option / 64] |= std::uint64_t(given) << (option % 64);
+                ++option;
+                numGiven += given;
+                if (group.policy == Policy::required && !given)
+                    error({"missing required option ", o.first});
+                auto validator = group.validators.find(o.first);
+                if (!given || validator == group.validators.end())
+                    continue;
+                StringVector values = getMultiParameters(o.first);
+                if (!alternative.empty()) {
+                    StringVector alternativeValues = getMultiParameters(alternative);
+                    values.insert(values.end(), alternativeValues.begin(), alternativeValues.end());
+                }
+                if (const String* value = values.empty() ? findEnvironmentValue(o.first) : nullptr)
+                    values.push_back(*value);
+                for (auto& value : values) {
+                    if (!validator->second(value))
+                        error({"invalid value ", value, " for ", o.first, ", expected ", validator->second.expectation()});
+                }
+            }
+            if (group.options.empty())
+                continue;
+            if ((group.policy == Policy::anyOf || group.policy == Policy::exactlyOne) && numGiven == 0)
+                error({"missing one of the options of [", group.groupDescription, "]"});
+            else if ((group.policy == Policy::exactlyOne || group.policy == Policy::atMostOne) && numGiven > 1)
+                error({"only one of the options of [", group.groupDescription, "] can be given"});
+        }
+        for (auto& c : schema->constraints) {
+            if (!isGiven(c.option) || isGiven(c.other) != c.conflict)
+                continue;
+            auto& rule = c.conflict ? schema->optionGroups[c.group].conflicts[c.rule] : schema->optionGroups[c.group].requirements[c.rule];
+            if (c.conflict)
+                error({rule.first, " can't be given together with ", rule.second});
+            else
+                error({rule.first, " requires ", rule.second});
+        }
+        return errors;
+    }
+
+    // index of the option's parameter among the choices of its validator, Status::invalidValue if it isn't one of them
+    Expected<int> getChoice(ArgView option) const MINICMD_NOEXCEPT {
+        Expected<String> value = tryGetParameter(option);
+        if (!value)
+            return Expected<int>{-1, value.status};
+        const Validator* validator = findValidator(option);
+        int choice = validator ? validator->choice(value.value) : -1;
+        return Expected<int>{choice, choice >= 0 ? Status::ok : Status::invalidValue};
+    }
+
+    // value of the key in a map option, looked up in constant time, Status::missingOption if the key isn't given
+    Expected<ArgView> getMapValue(ArgView option, ArgView key) const MINICMD_NOEXCEPT {
+        tokenKinds();
+        std::int32_t id = exactOption(option);
+        if (id < 0 || !schema->mapOptionIds[id] || mapEntries.empty())
+            return Expected<ArgView>{ArgView(), Status::missingOption};
+        size_t slot = findMapEntry(id, key, mapKeyHash(id, key));
+        if (mapEntries[slot].option < 0)
+            return Expected<ArgView>{ArgView(), Status::missingOption};
+        return Expected<ArgView>{mapValue(mapEntries[slot]), Status::ok};
+    }
+
+    // keys and values of a map option sorted by key, each key with its last value, unlike the values the keys
+    // aren't null-terminated
+    const minicmd::Vector<Allocator, std::pair<ArgView, ArgView>> getMapEntries(ArgView option) const MINICMD_NOEXCEPT {
+        tokenKinds();
+        std::int32_t id = exactOption(option);
+        minicmd::Vector<Allocator, std::pair<ArgView, ArgView>> entries(alloc);
+        for (auto& entry : mapEntries) {
+            if (id >= 0 && entry.option == id)
+                entries.push_back(std::make_pair(ArgView(tokenAt(entry.pos).data, entry.keySize), mapValue(entry)));
+        }
+        std::sort(entries.begin(), entries.end(), [](const std::pair<ArgView, ArgView>& a, const std::pair<ArgView, ArgView>& b) {
+            return minicmd::viewLess(a.first, b.first);
+        });
+        return entries;
+    }
+
+    // flag-like arguments that aren't declared, each once in the given order
+    const StringVector unknownOptions() const MINICMD_NOEXCEPT {
+        StringVector unknown(alloc);
+        tokenKinds();
+        for (size_t pos = 0; pos < tokens.size(); ++pos) {
+            ArgView token = tokenAt(pos);
+            if (kinds[pos] == TokenKind::unknown &&
+                std::find_if(unknown.begin(), unknown.end(), [&](const String& u) { return token == u; }) == unknown.end())
+                unknown.push_back(str(token));
+        }
+        return unknown;
+    }
+
+    // declared flags and alternatives closest to a mistyped one by edit distance, at most maxCount,
+    // the closest first, only ones within a third of the length are close enough
+    const StringVector suggestOptions(ArgView option, size_t maxCount = 3) const MINICMD_NOEXCEPT {
+        compileOptions();
+        minicmd::EditDistance distanceTo(option);
+        size_t maxDistance = std::max<size_t>(1, option.size / 3);
+        minicmd::Vector<Allocator, std::pair<size_t, const String*>> close(alloc);
+        for (auto& name : schema->declaredNames) {
+            size_t lengthDifference = name.size() > option.size ? name.size() - option.size : option.size - name.size();
+            if (lengthDifference > maxDistance)  // lower bound of the distance
+                continue;
+            size_t distance = distanceTo(name);
+            if (distance <= maxDistance)
+                close.push_back(std::make_pair(distance, &name));
+        }
+        std::stable_sort(close.begin(), close.end(), [](const std::pair<size_t, const String*>& a,
+                                                        const std::pair<size_t, const String*>& b) { return a.first < b.first; });
+        StringVector suggestions(alloc);
+        for (size_t i = 0; i < close.size() && i < maxCount; ++i)
+            suggestions.push_back(*close[i].second);
+        return suggestions;
+    }
+
+    // prints each unknown option with suggestions to std::cerr, false if there are any
+    bool checkUnknownOptions() const MINICMD_NOEXCEPT {
+        StringVector unknown = unknownOptions();
+        for (auto& option : unknown) {
+            std::cerr << "unknown option " << option;
+            StringVector suggestions = suggestOptions(option);
+            for (size_t i = 0; i < suggestions.size(); ++i)
+                std::cerr << (i == 0 ? ", did you mean " : " or ") << suggestions[i];
+            std::cerr << (suggestions.empty() ? "\n" : "?\n");
+        }
+        return unknown.empty();
+    }
+
+    void printHelpMessage(ArgView title = "\nUSAGE") const MINICMD_NOEXCEPT {
+        std::cerr << title << std::endl;
+        if (!subcommands.empty() && invokedSubcommand.empty()) {
+            std::cerr << "\n[subcommands]\n";
+            for (auto& s : subcommands)
+                std::cerr << s.first << "\t" << s.second << std::endl;
+        }
+        for (auto& group : schema->optionGroups) {
+            std::cerr << "\n[" + group.groupDescription + "]\n";
+            for (auto& o : group.options)
+                std::cerr << o.first << " " << o.second.second << "\t" << o.second.first << std::endl;
+        }
+    }
+
+    // if neither the flag nor its alternative has a parameter,
+    // the option falls back to its environment variable and then to its default value
+    const String getParameter(ArgView option) const MINICMD_NOEXCEPT {
+        size_t pos = findParameter(option);
+        if (pos != npos)
+            return str(tokenAt(pos));
+        if (isPrefixFamily(option)) {  // value of the first member
+            StringVector values = familyValues(option);
+            if (!values.empty())
+                return std::move(values.front());
+        }
+        if (const String* value = findEnvironmentValue(option))
+            return String(*value, alloc);
+        const DefaultValue* defaultValue = findDefault(option);
+        return defaultValue ? String(defaultValue->get().c_str(), defaultValue->get().size(), alloc) : String(alloc);
+    }
+
+    // for a prefix family, the values of all members in order
+    const StringVector getMultiParameters(ArgView option) const MINICMD_NOEXCEPT {
+        if (isPrefixFamily(option))
+            return familyValues(option);
+        StringVector params(alloc);
+        size_t pos = findToken(option);
+        if (pos != npos) {
+            size_t count = parametersOf(pos);
+            for (size_t i = pos + 1; i < pos + 1 + count; ++i)
+                params.push_back(str(tokenAt(i)));
+        }
+        return params;
+    }
+
+    // like getParameter, but tells a missing option from a missing parameter
+    Expected<String> tryGetParameter(ArgView option) const MINICMD_NOEXCEPT {
+        if (findParameter(option) != npos || (isPrefixFamily(option) && !familyValues(option).empty()) ||
+            findEnvironmentValue(option) != nullptr || findDefault(option) != nullptr)
+            return Expected<String>{getParameter(option), Status::ok};
+        return Expected<String>{String(alloc), optionExists(option) ? Status::missingParameter : Status::missingOption};
+    }
+
+    // also true if the option is set by its environment variable
+    bool optionExists(ArgView option) const MINICMD_NOEXCEPT {
+        if (isPrefixFamily(option)) {
+            bool exists = false;
+            forEachFamilyMember(option, [&](size_t) { exists = true; });
+            if (exists)
+                return true;
+        }
+        return findToken(option) != npos || findEnvironmentValue(option) != nullptr;
+    }
+
+    // adds an optional group with all options registered by MINICMD_FLAG
+    void addRegisteredOptions(ArgView groupDescription = "registered options") MINICMD_NOEXCEPT {
+        BasicOptionGroup<Allocator> registered(Policy::optional, groupDescription, alloc);
+        for (const RegisteredOption* o = RegisteredOption::first(); o != nullptr; o = o->next)
+            registered.addOption(o->flag, o->description);
+        addOptionGroup(registered);
+    }
+
+    // sets the FLAG_ globals of all registered options that are given, a flag without parameter sets a bool
+    // to true, returns Status::invalidValue if a parameter couldn't be parsed, which keeps that flag's value
+    Status applyRegisteredOptions() const MINICMD_NOEXCEPT {
+        Status result = Status::ok;
+        for (const RegisteredOption* o = RegisteredOption::first(); o != nullptr; o = o->next) {
+            if (optionExists(o->flag) && !o->assign(getParameter(o->flag).c_str()))
+                result = Status::invalidValue;
+        }
+        return result;
+    }
+
+    // canonical form of the invocation, e.g. for cache keys: the positional arguments, then the given options
+    // by their flag in sorted order, each occurrence followed by its parameters, occurrences of the same option
+    // keep their order, then unknown options with their parameters in the given order, and finally -- with the operands,
+    // so aliases, --flag=value and the order of the options don't matter, the environment and defaults aren't part of it
+    const StringVector canonicalArguments() const MINICMD_NOEXCEPT {
+        StringVector canonical(alloc);
+        auto given = givenOptions();
+        size_t positional = positionalArguments();
+        for (size_t pos = 0; pos < tokens.size(); ++pos) {
+            if (isPositionalAt(pos, positional))
+                canonical.push_back(str(tokenAt(pos)));
+        }
+        for (auto& o : given) {
+            canonical.push_back(isPrefixFamily(*o.first) ? str(tokenAt(o.second)) : *o.first);
+            size_t end = o.second + 1 + parametersOf(o.second);
+            for (size_t pos = o.second + 1; pos < end; ++pos)
+                canonical.push_back(str(tokenAt(pos)));
+        }
+        for (size_t pos : unknownArguments(given, positional))
+            canonical.push_back(str(tokenAt(pos)));
+        if (operandsBegin != npos) {
+            canonical.push_back(String("--", alloc));
+            for (size_t pos = operandsBegin; pos < operandsEnd; ++pos)
+                canonical.push_back(str(tokenAt(pos)));
+        }
+        return canonical;
+    }
+
+    // 64 bit hash of canonicalArguments(), combined from the token hashes computed while tokenizing
+    // without building the canonical form, different options are combined independently of their order
+    std::uint64_t canonicalHash() const MINICMD_NOEXCEPT {
+        auto given = givenOptions();
+        std::uint64_t hash = minicmd::hashBytes(nullptr, 0);
+        size_t positional = positionalArguments();
+        for (size_t pos = 0; pos < tokens.size(); ++pos) {
+            if (isPositionalAt(pos, positional))
+                hash = minicmd::hashCombine(hash, tokenHashes[pos]);
+        }
+        std::uint64_t options = 0;
+        for (size_t i = 0; i < given.size(); ) {
+            const String* flag = given[i].first;
+            std::uint64_t option = minicmd::hashBytes(flag->data(), flag->size());
+            for (; i < given.size() && given[i].first == flag; ++i) {  // occurrences in order
+                option = minicmd::hashCombine(option, isPrefixFamily(*flag) ? tokenHashes[given[i].second] :
+                                                                              minicmd::hashBytes(flag->data(), flag->size()));
+                size_t end = given[i].second + 1 + parametersOf(given[i].second);
+                for (size_t pos = given[i].second + 1; pos < end; ++pos)
+                    option = minicmd::hashCombine(option, tokenHashes[pos]);
+            }
+            options += minicmd::mixHash(option);
+        }
+        hash = minicmd::hashCombine(hash, options);
+        for (size_t pos : unknownArguments(given, positional))
+            hash = minicmd::hashCombine(hash, tokenHashes[pos]);
+        if (operandsBegin != npos) {
+            hash = minicmd::hashCombine(hash, minicmd::hashBytes("--", 2));
+            for (size_t pos = operandsBegin; pos < operandsEnd; ++pos)
+                hash = minicmd::hashCombine(hash, tokenHashes[pos]);
+        }
+        return hash;
+    }
+
+    // compact binary form of the tokens for passing a parse result to worker processes, e.g. over a pipe:
+    // magic, version, flags, the range of operands after --, token count, the end offset of each token with the top bit
+    // set if it was split off before an =, the index as the position of each distinct token's first occurrence ordered
+    // by the sorted tokens, the size of the subcommand, the null-terminated tokens and the null-terminated subcommand,
+    // offsets are relative so the blob can be copied or mapped anywhere
+    const String serialize() const MINICMD_NOEXCEPT {
+        while (tokenizeNext()) {}
+        String data(alloc);
+        size_t tokenBytes = 0;
+        for (auto& t : tokens)
+            tokenBytes += t.size + 1;
+        minicmd::Vector<Allocator, size_t> sorted(alloc);  // first occurrences in the order of the tokens
+        for (size_t i = 0; i < sortedIndex.size / 4; ++i)
+            sorted.push_back(minicmd::readUint32(viewOf(sortedIndex).data + 4 * i));
+        for (size_t pos : indexSlots) {
+            if (pos != npos)
+                sorted.push_back(pos);
+        }
+        if (sortedIndex.size == 0)
+            std::sort(sorted.begin(), sorted.end(), [this](size_t a, size_t b) { return minicmd::viewLess(tokenAt(a), tokenAt(b)); });
+        data.reserve(serializedMagicSize + 4 * (7 + tokens.size() + sorted.size()) + tokenBytes + invokedSubcommand.size() + 1);
+        data.append(serializedMagic, serializedMagicSize);
+        minicmd::appendUint32(data, serializedVersion);
+        minicmd::appendUint32(data, unixFlags ? 1 : 0);
+        minicmd::appendUint32(data, static_cast<std::uint32_t>(operandsBegin));  // all bits set without --
+        minicmd::appendUint32(data, static_cast<std::uint32_t>(operandsEnd));
+        minicmd::appendUint32(data, static_cast<std::uint32_t>(tokens.size()));
+        size_t end = 0;
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            end += tokens[i].size;
+            minicmd::appendUint32(data, static_cast<std::uint32_t>(end) | (splitTokens[i] ? splitBit : 0));
+            ++end;  // the terminator
+        }
+        minicmd::appendUint32(data, static_cast<std::uint32_t>(sorted.size()));
+        for (size_t pos : sorted)
+            minicmd::appendUint32(data, static_cast<std::uint32_t>(pos));
+        minicmd::appendUint32(data, static_cast<std::uint32_t>(invokedSubcommand.size()));
+        for (size_t i = 0; i < tokens.size(); ++i)
+            data.append(tokenAt(i).data, tokens[i].size).push_back('\0');
+        data.append(invokedSubcommand).push_back('\0');
+        return data;
+    }
+
+    // restores the tokens of serialize() without splitting the arguments again from one copy of the data, whose
+    // tokens and sorted index are used as they are, the subcommand is restored and its builder is called when
+    // it's added again, like the option groups, status() is Status::invalidFormat if the data is truncated or inconsistent
+    static BasicMiniCommander deserialize(ArgView data, const Allocator& alloc = Allocator()) MINICMD_NOEXCEPT {
+        return restore(data, false, alloc);
+    }
+
+    // like deserialize, but the tokens are views into the data, which must outlive the MiniCommander then, e.g. a mapped file
+    static BasicMiniCommander deserializeView(ArgView data, const Allocator& alloc = Allocator()) MINICMD_NOEXCEPT {
+        return restore(data, true, alloc);
+    }
+
+    // arguments that don't belong to a declared option, i.e. positional ones and unknown options,
+    // with the program name first if one is given, in lazy mode tokens that are a whole argv element reuse its pointer
+    ArgvBuilder forwardArguments(ArgView program = ArgView()) const MINICMD_NOEXCEPT {
+        ArgvBuilder builder(alloc);
+        if (program.size > 0)
+            builder.add(program);
+        auto forward = [&](size_t pos) {
+            if (pos < tokenOrigins.size() && tokenOrigins[pos] >= 0)
+                builder.addBorrowed(argv[tokenOrigins[pos]]);
+            else
+                builder.add(tokenAt(pos));
+        };
+        for (size_t pos = 0; hasToken(pos); ++pos) {
+            if (isOperand(pos))
+                continue;
+            if (kindAt(pos) == TokenKind::flag)
+                pos += parametersOf(pos);  // consumed with its parameters
+            else
+                forward(pos);
+        }
+        if (operandsBegin != npos) {
+            builder.add("--");
+            for (size_t pos = operandsBegin; pos < operandsEnd; ++pos)
+                forward(pos);
+        }
+        return builder;
+    }
+
+    // does all lazy work up front, i.e. tokenizes all arguments, reads the environment and evaluates
+    // the defaults, afterwards the const queries don't modify anything and can run concurrently
+    void freeze() MINICMD_NOEXCEPT {
+        while (tokenizeNext()) {}
+        environment();
+        compileOptions();
+        classifyTokens();
+        for (auto& d : schema->optionDefaults) {
+            if (d.exists())
+                d.get();
+        }
+    }
+
+private:
+    static const size_t npos = static_cast<size_t>(-1);
+    static constexpr const char* serializedMagic = "MCMD";
+    static const size_t serializedMagicSize = 4;
+    static const std::uint32_t serializedVersion = 4;
+    static const std::uint32_t splitBit = 0x80000000u;
+
+    // bytes in text, or borrowed from memory that outlives the MiniCommander, i.e. a serialized blob
+    struct Token {
+        const char* borrowed;  // nullptr if the bytes are in text
+        size_t offset;  // in text
+        size_t size;
+    };
+
+    // deserializes the data, borrowing from it or from a copy in text
+    static BasicMiniCommander restore(ArgView data, bool borrow, const Allocator& alloc) {
+        const char* pos = data.data;
+        const char* end = data.data + data.size;
+        auto readable = [&](size_t words) { return size_t(end - pos) / 4 >= words; };
+        bool valid = data.size >= serializedMagicSize + 28 && std::memcmp(pos, serializedMagic, serializedMagicSize) == 0;
+        pos += serializedMagicSize;
+        valid = valid && minicmd::readUint32(pos) == serializedVersion;
+        BasicMiniCommander cmd(ArgView(), valid && (minicmd::readUint32(pos + 4) & 1), alloc);
+        std::uint32_t operandsBegin = valid ? minicmd::readUint32(pos + 8) : 0;
+        std::uint32_t operandsEnd = valid ? minicmd::readUint32(pos + 12) : 0;
+        size_t numTokens = valid ? minicmd::readUint32(pos + 16) : 0;
+        pos += 20;
+        bool hasOperands = operandsBegin != static_cast<std::uint32_t>(npos);
+        valid = valid && (!hasOperands || (operandsBegin <= operandsEnd && operandsEnd <= numTokens));
+        valid = valid && readable(numTokens + 1);
+        const char* ends = pos;
+        pos += 4 * numTokens;
+        size_t numIndex = valid ? minicmd::readUint32(pos) : 0;
+        pos += 4;
+        valid = valid && readable(numIndex + 1);
+        const char* positions = pos;
+        pos += 4 * numIndex;
+        size_t subcommandSize = valid ? minicmd::readUint32(pos) : 0;
+        pos += 4;
+        size_t tokenBytes = (valid && numTokens > 0) ? (minicmd::readUint32(ends + 4 * (numTokens - 1)) & ~splitBit) + 1 : 0;
+        valid = valid && size_t(end - pos) >= tokenBytes && size_t(end - pos) - tokenBytes == subcommandSize + 1 && end[-1] == '\0';
+        if (!valid) {
+            cmd.state = Status::invalidFormat;
+            return cmd;
+        }
+        size_t copied = borrow ? 0 : cmd.appendText(data);
+        auto locate = [&](const char* bytes, size_t size) {
+            return borrow ? Token{bytes, 0, size} : Token{nullptr, copied + (bytes - data.data), size};
+        };
+        cmd.tokens.reserve(numTokens);
+        cmd.tokenHashes.reserve(numTokens);
+        for (size_t i = 0, begin = 0; i < numTokens; ++i) {
+            std::uint32_t word = minicmd::readUint32(ends + 4 * i);
+            size_t tokenEnd = word & ~splitBit;
+            bool split = (word & splitBit) != 0;
+            if (tokenEnd < begin || tokenEnd >= tokenBytes || pos[tokenEnd] != '\0' || (split && i + 1 == numTokens)) {
+                cmd.state = Status::invalidFormat;  // split tokens have a successor
+                break;
+            }
+            cmd.tokens.push_back(locate(pos + begin, tokenEnd - begin));
+            cmd.tokenHashes.push_back(minicmd::hashBytes(pos + begin, tokenEnd - begin));
+            cmd.splitTokens.push_back(split);
+            begin = tokenEnd + 1;
+        }
+        for (size_t i = 0; i < numIndex && cmd.state == Status::ok; ++i) {  // strictly ascending for the binary search
+            size_t position = minicmd::readUint32(positions + 4 * i);
+            size_t previous = i > 0 ? minicmd::readUint32(positions + 4 * (i - 1)) : 0;
+            if (position >= numTokens || (i > 0 && !minicmd::viewLess(cmd.tokenAt(previous), cmd.tokenAt(position))))
+                cmd.state = Status::invalidFormat;
+        }
+        if (hasOperands) {
+            cmd.operandsBegin = operandsBegin;
+            cmd.operandsEnd = operandsEnd;
+        }
+        if (cmd.state != Status::ok) {
+            cmd.operandsBegin = npos;
+            cmd.tokens.clear();
+            cmd.tokenHashes.clear();
+            cmd.splitTokens.clear();
+            return cmd;
+        }
+        cmd.sortedIndex = locate(positions, 4 * numIndex);
+        cmd.invokedSubcommand.assign(pos + tokenBytes, subcommandSize);
+        return cmd;
+    }
+
+    // like isOption, but reuses the classification of the token
+    bool isOptionAt(size_t pos) const {
+        if (isOperand(pos))
+            return false;
+        return kindAt(pos) == TokenKind::flag || (unixFlags && tokens[pos].size > 0 && tokenAt(pos).data[0] == '-' && !schema->optionGroups.empty());
+    }
+
+    // neither an option nor an operand after --
+    bool isParameterAt(size_t pos) const {
+        return !isOperand(pos) && !isOptionAt(pos);
+    }
+
+    TokenKind kindAt(size_t pos) const {
+        compileOptions();
+        if (pos >= kinds.size())
+            classifyTokens();
+        return kinds[pos];
+    }
+
+    // number of parameters of the token, precomputed for declared flags, undeclared ones take
+    // all following tokens up to the next option, e.g. without option groups
+    size_t parametersOf(size_t pos) const {
+        if (kindAt(pos) != TokenKind::flag) {
+            size_t end = pos + 1;
+            while (hasToken(end) && isParameterAt(end))
+                ++end;
+            return end - pos - 1;
+        }
+        while (classification.flag == pos && tokenizeNext())  // more parameters may follow
+            classifyTokens();
+        return numParameters[pos];
+    }
+
+    // positional argument other than an operand, also the tokens before the first option
+    // if they aren't classified as positional, e.g. without option groups
+    bool isPositionalAt(size_t pos, size_t leading) const {
+        return pos < leading || (!isOperand(pos) && kindAt(pos) == TokenKind::positional);
+    }
+
+    bool declaresArities() const {
+        compileOptions();
+        for (auto& arity : schema->optionArities) {
+            if (arity.first)
+                return true;
+        }
+        return false;
+    }
+
+    // classifies the tokens added since the last time in one pass and assigns the parameters to their flags,
+    // the kinds are reset when options are compiled
+    void classifyTokens() const {
+        compileOptions();
+        Classification& c = classification;
+        for (size_t pos = kinds.size(); pos < tokens.size(); ++pos) {
+            ArgView token = tokenAt(pos);
+            std::int32_t option = isOperand(pos) ? -1 : matchOption(token);
+            numParameters.push_back(0);
+            bool declared = c.option >= 0 && schema->optionArities[c.option].first;
+            bool parameter = false;
+            TokenKind kind;
+            if (option >= 0) {
+                kind = TokenKind::flag;
+                c.flag = pos;
+                c.option = option;
+            } else if (isOperand(pos)) {
+                kind = TokenKind::positional;
+                c.flag = npos;
+            } else if (c.flag != npos && (declared || !(unixFlags && !token.empty() && token.data[0] == '-'))) {
+                parameter = true;
+                kind = (!declared && minicmd::looksLikeOption(token)) ? TokenKind::unknown : TokenKind::parameter;
+                ++numParameters[c.flag];
+                if (schema->mapOptionIds[c.option] && !(pos - 1 > c.flag && splitTokens[pos - 1]))  // not the value of a split key
+                    addMapEntry(c.option, pos);
+            } else {
+                c.flag = npos;
+                kind = minicmd::looksLikeOption(token) ? TokenKind::unknown :
+                    (c.positional ? TokenKind::positional : TokenKind::parameter);
+            }
+            c.positional = kind == TokenKind::positional && !isOperand(pos);
+            bool joined = option >= 0 && hasJoinedValue(token, option);
+            if (joined || ((option >= 0 || parameter) && schema->optionArities[c.option].first &&
+                           numParameters[c.flag] == schema->optionArities[c.option].second.max)) {  // all parameters assigned
+                c.flag = npos;
+                c.positional = true;
+            }
+            numUnknown += (kind == TokenKind::unknown);
+            if (kind == TokenKind::positional)
+                positionals.push_back(pos);
+            kinds.push_back(kind);
+        }
+    }
+
+    // whether the token is a member of the prefix family with its value joined, like -I/usr/include,
+    // which takes no further parameters, unlike a bare -I
+    bool hasJoinedValue(ArgView token, std::int32_t option) const {
+        if (exactOption(token) >= 0)
+            return false;
+        std::int64_t node = findNode(token);
+        return node < 0 || schema->trieNodes[node].prefix != option;
+    }
+
+    // requirement or conflict between two declared options, compiled to the numbers of the options
+    struct Constraint {
+        std::int32_t option;
+        std::int32_t other;
+        bool conflict;
+        std::uint32_t group;  // declared in this group
+        std::uint32_t rule;  // at this index of its requirements or conflicts
+    };
+
+    // key=value parameter of a map option in the open addressing table, the key and value are views of the token,
+    // or of the token and the next one if the argument was split at its =
+    struct MapEntry {
+        std::uint64_t hash;
+        std::int32_t option;  // -1 for an empty slot
+        std::uint32_t keySize;
+        size_t pos;  // of the token
+    };
+
+    static std::uint64_t mapKeyHash(std::int32_t option, ArgView key) {
+        return minicmd::mixHash(minicmd::hashCombine(minicmd::hashBytes(key.data, key.size), static_cast<std::uint64_t>(option)));
+    }
+
+    ArgView mapValue(const MapEntry& entry) const {
+        ArgView token = tokenAt(entry.pos);
+        if (splitTokens[entry.pos])
+            return tokenAt(entry.pos + 1);
+        return entry.keySize < token.size ? ArgView(token.data + entry.keySize + 1, token.size - entry.keySize - 1) : ArgView();
+    }
+
+    // slot of the key with linear probing, the empty slot where it belongs if it isn't in the table
+    size_t findMapEntry(std::int32_t option, ArgView key, std::uint64_t hash) const {
+        size_t mask = mapEntries.size() - 1;
+        for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+            const MapEntry& entry = mapEntries[slot];
+            if (entry.option < 0 || (entry.hash == hash && entry.option == option && entry.keySize == key.size &&
+                                     std::memcmp(tokenAt(entry.pos).data, key.data, key.size) == 0))
+                return slot;
+        }
+    }
+
+    // splits the parameter at its first = unless it was split off its value already, and inserts it,
+    // or replaces the previous value of its key
+    void addMapEntry(std::int32_t option, size_t pos) const {
+        if (2 * (numMapEntries + 1) > mapEntries.size()) {  // keeps the load factor at most 1/2
+            minicmd::Vector<Allocator, MapEntry> entries(std::max<size_t>(16, 2 * mapEntries.size()), MapEntry{0, -1, 0, 0}, alloc);
+            entries.swap(mapEntries);
+            for (auto& entry : entries) {
+                if (entry.option >= 0)
+                    mapEntries[findMapEntry(entry.option, ArgView(tokenAt(entry.pos).data, entry.keySize), entry.hash)] = entry;
+            }
+        }
+        ArgView token = tokenAt(pos);
+        const char* equal = splitTokens[pos] ? nullptr : static_cast<const char*>(std::memchr(token.data, '=', token.size));
+        ArgView key(token.data, equal ? equal - token.data : token.size);
+        std::uint64_t hash = mapKeyHash(option, key);
+        MapEntry& entry = mapEntries[findMapEntry(option, key, hash)];
+        numMapEntries += entry.option < 0;
+        entry = MapEntry{hash, option, static_cast<std::uint32_t>(key.size), pos};
+    }
+
+    // state of classifyTokens between calls
+    struct Classification {
+        size_t flag;  // position of the flag the next parameter belongs to, npos if none
+        std::int32_t option;  // declared option of the last flag
+        bool positional;  // the next token that's neither a flag nor a parameter is positional
+    };
+
+    static bool isPrefixFamily(ArgView flag) {
+        return flag.size > 1 && flag.data[flag.size - 1] == '*';
+    }
+
+    // node of the compiled option trie, its children are a contiguous range of edges sorted by label
+    struct TrieNode {
+        std::uint32_t firstEdge;
+        std::uint32_t numEdges;
+        std::int32_t exact;  // declared option whose flag ends here, or -1
+        std::int32_t prefix;  // declared prefix family whose prefix ends here, or -1
+        std::int32_t abbreviated;  // the only long option below, -1 if there is none, -2 if there are several
+        std::int32_t longName;  // its name in longNames
+    };
+
+    struct TrieEdge {
+        char label;
+        std::uint32_t target;
+    };
+
+    // the option groups and what's compiled from them, indexed by the number of each declared option
+    struct Schema {
+        minicmd::Vector<Allocator, BasicOptionGroup<Allocator>> optionGroups;
+        bool compiled;
+        minicmd::Vector<Allocator, TrieNode> trieNodes;
+        minicmd::Vector<Allocator, TrieEdge> trieEdges;
+        StringVector longNames;  // names abbreviations resolve to
+        StringVector declaredNames;  // all flags and alternatives except prefix families
+        minicmd::Vector<Allocator, std::pair<bool, Arity>> optionArities;  // of each declared option, if it has one
+        minicmd::Vector<Allocator, Constraint> constraints;
+        minicmd::Vector<Allocator, bool> mapOptionIds;  // whether each declared option is a map option
+        minicmd::Vector<Allocator, std::pair<String, String>> optionNames;  // flag and alternative of each declared option
+        StringVector optionVariables;  // environment variable bound to each declared option, empty if none
+        minicmd::Vector<Allocator, DefaultValue> optionDefaults;  // of each declared option, sharing the group's value
+        explicit Schema(const Allocator& alloc)
+            : optionGroups(alloc), compiled(false), trieNodes(alloc), trieEdges(alloc), longNames(alloc), declaredNames(alloc),
+              optionArities(alloc), constraints(alloc), mapOptionIds(alloc), optionNames(alloc), optionVariables(alloc),
+              optionDefaults(alloc) {}
+        Schema(const Schema& other, const Allocator& alloc)
+            : optionGroups(alloc), compiled(other.compiled), trieNodes(other.trieNodes, alloc), trieEdges(other.trieEdges, alloc),
+              longNames(other.longNames, alloc), declaredNames(other.declaredNames, alloc),
+              optionArities(other.optionArities, alloc), constraints(other.constraints, alloc),
+              mapOptionIds(other.mapOptionIds, alloc), optionNames(other.optionNames, alloc),
+              optionVariables(other.optionVariables, alloc), optionDefaults(other.optionDefaults, alloc) {
+            optionGroups.reserve(other.optionGroups.size());
+            for (auto& group : other.optionGroups)
+                optionGroups.emplace_back(group, alloc);
+        }
+    };
+
+    // compiles the schema if options were added since the last time, unless it's compiled already, e.g. for
+    // another MiniCommander sharing it, and resets the classification of the tokens
+    void compileOptions() const {
+        if (!schemaDirty)
+            return;
+        schemaDirty = false;
+        if (!schema->compiled) {
+            if (schema.use_count() > 1)  // e.g. copied before it was compiled
+                schema = std::allocate_shared<Schema>(alloc, *schema, alloc);
+            compileSchema();
+        }
+        if (abbreviations)
+            resolveAbbreviations();
+        kinds.clear();
+        numUnknown = 0;
+        mapEntries.clear();
+        numMapEntries = 0;
+        numParameters.clear();
+        positionals.clear();
+        classification = Classification{npos, -1, true};
+    }
+
+    // compiles all flags, alternatives and prefix families into a trie, the constraints and the fallbacks of each option
+    void compileSchema() const {
+        struct Node {
+            minicmd::Map<Allocator, char, std::uint32_t> children;
+            std::int32_t exact;
+            std::int32_t prefix;
+            std::int32_t abbreviated;
+            std::int32_t longName;
+            explicit Node(const Allocator& alloc)
+                : children(std::less<char>(), alloc), exact(-1), prefix(-1), abbreviated(-1), longName(-1) {}
+        };
+        minicmd::Vector<Allocator, Node> nodes(alloc);
+        nodes.emplace_back(alloc);  // the root, nodes are never copied, copies of the maps would take the default allocator
+        schema->longNames.clear();
+        schema->declaredNames.clear();
+        auto insert = [&](const String& flag, std::int32_t option) {
+            bool family = isPrefixFamily(flag);
+            if (!family)
+                schema->declaredNames.push_back(flag);
+            bool longOption = !family && flag.size() > 2 && flag[0] == '-' && flag[1] == '-';
+            if (longOption)
+                schema->longNames.push_back(flag);
+            std::uint32_t node = 0;
+            for (size_t i = 0; i < flag.size() - family; ++i) {
+                auto child = nodes[node].children.find(flag[i]);
+                if (child == nodes[node].children.end()) {
+                    nodes.push_back(Node(alloc));
+                    child = nodes[node].children.insert(std::make_pair(flag[i], std::uint32_t(nodes.size() - 1))).first;
+                }
+                node = child->second;
+                if (longOption && nodes[node].abbreviated == -1) {
+                    nodes[node].abbreviated = option;
+                    nodes[node].longName = static_cast<std::int32_t>(schema->longNames.size() - 1);
+                } else if (longOption && nodes[node].abbreviated != option) {
+                    nodes[node].abbreviated = -2;  // ambiguous
+                }
+            }
+            std::int32_t& match = family ? nodes[node].prefix : nodes[node].exact;
+            if (match < 0)  // the first declaration wins
+                match = option;
+        };
+        std::int32_t numDeclared = 0;
+        schema->optionArities.clear();
+        schema->mapOptionIds.clear();
+        for (auto& group : schema->optionGroups) {
+            for (auto& o : group.options) {
+                schema->mapOptionIds.push_back(std::find(group.mapOptions.begin(), group.mapOptions.end(), o.first) != group.mapOptions.end());
+                auto arity = group.arities.find(o.first);
+                schema->optionArities.push_back(arity != group.arities.end() ? std::make_pair(true, arity->second) :
+                                                                       std::make_pair(false, Arity::none()));
+                insert(o.first, numDeclared);
+                if (!o.second.second.empty())
+                    insert(o.second.second, numDeclared);
+                ++numDeclared;
+            }
+        }
+        schema->trieNodes.clear();
+        schema->trieEdges.clear();
+        for (auto& node : nodes) {
+            schema->trieNodes.push_back(TrieNode{std::uint32_t(schema->trieEdges.size()), std::uint32_t(node.children.size()),
+                                         node.exact, node.prefix, node.abbreviated, node.longName});
+            for (auto& child : node.children)
+                schema->trieEdges.push_back(TrieEdge{child.first, child.second});
+        }
+        schema->constraints.clear();
+        for (std::uint32_t g = 0; g < schema->optionGroups.size(); ++g) {
+            for (bool conflict : {false, true}) {
+                auto& rules = conflict ? schema->optionGroups[g].conflicts : schema->optionGroups[g].requirements;
+                for (std::uint32_t r = 0; r < rules.size(); ++r) {
+                    Constraint constraint{exactOption(rules[r].first), exactOption(rules[r].second), conflict, g, r};
+                    if (constraint.option >= 0 && constraint.other >= 0)  // undeclared options are never given
+                        schema->constraints.push_back(constraint);
+                }
+            }
+        }
+        schema->optionNames.assign(numDeclared, std::make_pair(String(alloc), String(alloc)));
+        schema->optionVariables.assign(numDeclared, String(alloc));
+        schema->optionDefaults.assign(numDeclared, DefaultValue());
+        for (auto& group : schema->optionGroups) {  // bound to the first declaration of a flag, the first binding wins
+            for (auto& o : group.options) {
+                std::int32_t id = declaredOption(o.first);
+                if (id < 0)
+                    continue;
+                if (schema->optionNames[id].first.empty()) {
+                    schema->optionNames[id].first = o.first;
+                    schema->optionNames[id].second = o.second.second;
+                }
+                auto variable = group.environmentVariables.find(o.first);
+                if (variable != group.environmentVariables.end() && schema->optionVariables[id].empty())
+                    schema->optionVariables[id] = variable->second;
+                auto defaultValue = group.defaults.find(o.first);
+                if (defaultValue != group.defaults.end() && !schema->optionDefaults[id].exists())
+                    schema->optionDefaults[id] = defaultValue->second;
+            }
+        }
+        schema->compiled = true;
+    }
+
+    // number of the declared option with this flag or alternative, or of the prefix family, -1 if there is none
+    std::int32_t declaredOption(ArgView flag) const {
+        compileOptions();
+        return isPrefixFamily(flag) ? matchOption(ArgView(flag.data, flag.size - 1), true) : exactOption(flag);
+    }
+
+    // number of the declared option with this flag or alternative, -1 if there is none
+    std::int32_t exactOption(ArgView flag) const {
+        std::int64_t node = findNode(flag);
+        return node >= 0 ? schema->trieNodes[node].exact : -1;
+    }
+
+    // trie node reached by the token, -1 if there is none
+    std::int64_t findNode(ArgView token) const {
+        std::uint32_t node = 0;
+        for (size_t i = 0; i < token.size; ++i) {
+            const TrieNode& n = schema->trieNodes[node];
+            auto first = schema->trieEdges.begin() + n.firstEdge;
+            auto last = first + n.numEdges;
+            auto edge = std::lower_bound(first, last, token.data[i], [](const TrieEdge& e, char c) { return e.label < c; });
+            if (edge == last || edge->label != token.data[i])
+                return -1;
+            node = edge->target;
+        }
+        return node;
+    }
+
+    // full name of a long option abbreviated by the token, nullptr if it isn't an abbreviation,
+    // sets ambiguousAbbreviation if it abbreviates several options
+    const String* abbreviatedOption(ArgView token) const {
+        if (token.size <= 2 || token.data[0] != '-' || token.data[1] != '-')
+            return nullptr;
+        std::int64_t node = findNode(token);
+        if (node < 0 || schema->trieNodes[node].exact >= 0)
+            return nullptr;
+        if (schema->trieNodes[node].abbreviated == -2)
+            ambiguousAbbreviation = true;
+        return schema->trieNodes[node].abbreviated >= 0 ? &schema->longNames[schema->trieNodes[node].longName] : nullptr;
+    }
+
+    // replaces the abbreviations among all tokens by the full names and reindexes them
+    void resolveAbbreviations() const {
+        while (tokenizeNext()) {}
+        ambiguousAbbreviation = false;
+        bool replaced = false;
+        for (size_t pos = 0; pos < tokens.size(); ++pos) {
+            if (isOperand(pos))
+                continue;
+            if (const String* name = abbreviatedOption(tokenAt(pos))) {
+                tokens[pos] = Token{nullptr, appendText(*name), name->size()};
+                tokenHashes[pos] = minicmd::hashBytes(name->data(), name->size());
+                if (pos < tokenOrigins.size())
+                    tokenOrigins[pos] = -1;
+                replaced = true;
+            }
+        }
+        if (!replaced)
+            return;
+        indexSlots.clear();
+        numIndexed = 0;
+        sortedIndex = Token{nullptr, 0, 0};
+        for (size_t pos = 0; pos < tokens.size(); ++pos) {
+            if (!isOperand(pos))
+                indexToken(pos);
+        }
+    }
+
+    // number of the declared option matching a token, an exact flag or else the longest matching
+    // prefix family, -1 if none, linear in the token length, with family the token is the prefix of a family
+    std::int32_t matchOption(ArgView token, bool family = false) const {
+        compileOptions();
+        std::int32_t match = -1;
+        std::uint32_t node = 0;
+        for (size_t i = 0; ; ++i) {
+            const TrieNode& n = schema->trieNodes[node];
+            if (n.prefix >= 0)
+                match = n.prefix;
+            if (i == token.size)
+                return family ? n.prefix : (n.exact >= 0 ? n.exact : match);
+            auto first = schema->trieEdges.begin() + n.firstEdge;
+            auto last = first + n.numEdges;
+            auto edge = std::lower_bound(first, last, token.data[i], [](const TrieEdge& e, char c) { return e.label < c; });
+            if (edge == last || edge->label != token.data[i])
+                return family ? -1 : match;
+            node = edge->target;
+        }
+    }
+
+    // calls f with the position of each token that belongs to the prefix family, i.e. whose best match it is
+    template<class F>
+    void forEachFamilyMember(ArgView family, F f) const {
+        while (tokenizeNext()) {}
+        ArgView prefix(family.data, family.size - 1);
+        std::int32_t declaration = matchOption(prefix, true);
+        for (size_t pos = 0; pos < tokens.size(); ++pos) {
+            ArgView token = tokenAt(pos);
+            if (isOperand(pos) || token.size < prefix.size || std::memcmp(token.data, prefix.data, prefix.size) != 0)
+                continue;
+            if (declaration < 0 || matchOption(token) == declaration)
+                f(pos);
+        }
+    }
+
+    // joined values of the members of a prefix family, or the next argument if a member has no joined value
+    StringVector familyValues(ArgView family) const {
+        StringVector values(alloc);
+        forEachFamilyMember(family, [&](size_t pos) {
+            ArgView token = tokenAt(pos);
+            if (token.size > family.size - 1)
+                values.push_back(String(token.data + family.size - 1, token.size - (family.size - 1), alloc));
+            else if (parametersOf(pos) > 0)
+                values.push_back(str(tokenAt(pos + 1)));
+        });
+        return values;
+    }
+
+    // splits the next argv element into tokens, returns false if argv is exhausted
+    bool tokenizeNext() const {
+        if (nextArg >= argc)
+            return false;
+        size_t first = tokens.size();
+        ArgView arg(argv[nextArg]);
+        addArgument(arg, appendText(arg));
+        tokenOrigins.resize(tokens.size(), -1);
+        if (tokens.size() == first + 1 && arg.size == tokens[first].size)
+            tokenOrigins[first] = nextArg;  // unsplit
+        ++nextArg;
+        return true;
+    }
+
+    // splits an argument into tokens, after the -- terminator it's added as it is as an operand,
+    // copied is the position of a copy of the argument in text, npos if it isn't copied yet
+    void addArgument(ArgView arg, size_t copied = npos) const {
+        if (operandsBegin != npos) {
+            addToken(arg, copied, true);
+            operandsEnd = tokens.size();
+        } else if (arg == "--") {
+            operandsBegin = operandsEnd = tokens.size();
+        } else {
+            minicmd::splitArgument(arg, unixFlags, [&](ArgView token, bool split) {
+                bool inCopy = copied != npos && minicmd::isWithin(token, arg);  // not a flag split off a cluster
+                addToken(token, inCopy ? copied + (token.data - arg.data) : npos, false, split);
+            });
+        }
+    }
+
+    // a token copied to text already is terminated there in place, others are appended,
+    // operands aren't indexed, so they're never taken for options
+    void addToken(ArgView token, size_t copied = npos, bool operand = false, bool split = false) const {
+        if (abbreviations && !schemaDirty && !operand) {
+            if (const String* name = abbreviatedOption(token)) {
+                token = *name;
+                copied = npos;
+            }
+        }
+        if (copied != npos)
+            text[copied + token.size] = '\0';
+        tokens.push_back(Token{nullptr, copied != npos ? copied : appendText(token), token.size});
+        tokenHashes.push_back(minicmd::hashBytes(token.data, token.size));
+        splitTokens.push_back(split);
+        if (!operand)
+            indexToken(tokens.size() - 1);
+    }
+
+    // appends a null-terminated copy to text, returns its position
+    size_t appendText(ArgView view) const {
+        size_t offset = text.size();
+        text.append(view.data, view.size);
+        text.push_back('\0');
+        return offset;
+    }
+
+    ArgView viewOf(const Token& t) const {
+        return ArgView(t.borrowed ? t.borrowed : text.data() + t.offset, t.size);
+    }
+
+    ArgView tokenAt(size_t pos) const {
+        return viewOf(tokens[pos]);
+    }
+
+    String str(ArgView view) const {
+        return String(view.data, view.size, alloc);
+    }
+
+    // slot of the token in the index with linear probing, the empty slot where it belongs if it isn't indexed
+    size_t findIndexSlot(ArgView token, std::uint64_t hash) const {
+        size_t mask = indexSlots.size() - 1;
+        for (size_t slot = minicmd::mixHash(hash) & mask; ; slot = (slot + 1) & mask) {
+            size_t pos = indexSlots[slot];
+            if (pos == npos || (tokenHashes[pos] == hash && tokenAt(pos) == token))
+                return slot;
+        }
+    }
+
+    // indexes the token unless an earlier occurrence is indexed already
+    void indexToken(size_t pos) const {
+        if (sortedIndex.size > 0) {  // a deserialized MiniCommander gets more tokens, the sorted index moves to the table
+            Token sorted = sortedIndex;
+            sortedIndex = Token{nullptr, 0, 0};
+            for (size_t i = 0; i < sorted.size / 4; ++i)
+                indexToken(minicmd::readUint32(viewOf(sorted).data + 4 * i));
+        }
+        if (2 * (numIndexed + 1) > indexSlots.size()) {  // keeps the load factor at most 1/2
+            minicmd::Vector<Allocator, size_t> slots(std::max<size_t>(16, 2 * indexSlots.size()), size_t(npos), alloc);
+            slots.swap(indexSlots);
+            for (size_t indexed : slots) {
+                if (indexed != npos)
+                    indexSlots[findIndexSlot(tokenAt(indexed), tokenHashes[indexed])] = indexed;
+            }
+        }
+        size_t& slot = indexSlots[findIndexSlot(tokenAt(pos), tokenHashes[pos])];
+        numIndexed += slot == npos;
+        slot = std::min(slot, pos);
+    }
+
+    bool isOperand(size_t pos) const {
+        return operandsBegin != npos && pos >= operandsBegin && pos < operandsEnd;
+    }
+
+    // tokenizes until the token shows up or argv is exhausted
+    size_t findToken(ArgView token) const {
+        if (abbreviations)
+            compileOptions();  // replaces the abbreviations
+        if (sortedIndex.size > 0)
+            return findSorted(token);
+        std::uint64_t hash = minicmd::hashBytes(token.data, token.size);
+        auto find = [&]() { return indexSlots.empty() ? npos : indexSlots[findIndexSlot(token, hash)]; };
+        size_t pos = find();
+        while (pos == npos && tokenizeNext())
+            pos = find();
+        return pos;
+    }
+
+    // binary search in the sorted index of a deserialized MiniCommander
+    size_t findSorted(ArgView token) const {
+        const char* positions = viewOf(sortedIndex).data;
+        size_t first = 0;
+        for (size_t count = sortedIndex.size / 4; count > 0; ) {
+            size_t half = count / 2;
+            if (minicmd::viewLess(tokenAt(minicmd::readUint32(positions + 4 * (first + half))), token)) {
+                first += half + 1;
+                count -= half + 1;
+            } else {
+                count = half;
+            }
+        }
+        size_t pos = first < sortedIndex.size / 4 ? minicmd::readUint32(positions + 4 * first) : npos;
+        return (pos != npos && tokenAt(pos) == token) ? pos : npos;
+    }
+
+    // reads files in one go if they fit into the buffer, also works for /proc files of unknown size
+    static bool readFile(ArgView path, String& contents) {
+        String fileName(path.data, path.size, contents.get_allocator());
+        std::FILE* file = std::fopen(fileName.c_str(), "rb");
+        if (file == nullptr)
+            return false;
+        size_t size = 0;
+        do {
+            contents.resize(std::max<size_t>(4096, 2 * size));
+            size += std::fread(&contents[size], 1, contents.size() - size, file);
+        } while (size == contents.size());
+        bool complete = !std::ferror(file);
+        std::fclose(file);
+        contents.resize(size);
+        return complete;
+    }
+
+    // tokenizes null-separated arguments, the first one is the program name, the tokens are
+    // views into one copy of them
+    void tokenizeArgumentList(ArgView arguments) {
+        size_t copied = appendText(arguments);
+        const char* end = arguments.data + arguments.size;
+        bool program = true;
+        for (const char* arg = arguments.data; arg < end; ) {
+            const char* argEnd = static_cast<const char*>(std::memchr(arg, '\0', end - arg));
+            argEnd = argEnd ? argEnd : end;
+            if (!program)
+                addArgument(ArgView(arg, argEnd - arg), copied + (arg - arguments.data));
+            program = false;
+            arg = argEnd + 1;
+        }
+    }
+
+    // every occurrence of a declared option, given by flag or alternative, with the position of the token,
+    // sorted by the declared flag, the occurrences of an option in the given order
+    minicmd::Vector<Allocator, std::pair<const String*, size_t>> givenOptions() const {
+        tokenKinds();
+        minicmd::Vector<Allocator, const String*> flags(alloc);  // of each declared option
+        for (auto& group : schema->optionGroups) {
+            for (auto& o : group.options)
+                flags.push_back(&o.first);
+        }
+        minicmd::Vector<Allocator, std::pair<const String*, size_t>> given(alloc);
+        for (size_t pos = 0; pos < tokens.size(); ++pos) {
+            if (kinds[pos] == TokenKind::flag)
+                given.push_back(std::make_pair(flags[matchOption(tokenAt(pos))], pos));
+        }
+        std::stable_sort(given.begin(), given.end(), [](const std::pair<const String*, size_t>& a,
+                                                        const std::pair<const String*, size_t>& b) { return *a.first < *b.first; });
+        return given;
+    }
+
+    // positions of the tokens that are neither positional, operands, nor declared options with their parameters,
+    // i.e. unknown options and their parameters
+    minicmd::Vector<Allocator, size_t> unknownArguments(const minicmd::Vector<Allocator, std::pair<const String*, size_t>>& given,
+                                                        size_t leading) const {
+        minicmd::Vector<Allocator, bool> consumed(tokens.size(), false, alloc);
+        for (auto& o : given)
+            std::fill(consumed.begin() + o.second, consumed.begin() + o.second + 1 + parametersOf(o.second), true);
+        minicmd::Vector<Allocator, size_t> unknown(alloc);
+        for (size_t pos = 0; pos < tokens.size(); ++pos) {
+            if (!consumed[pos] && !isOperand(pos) && !isPositionalAt(pos, leading))
+                unknown.push_back(pos);
+        }
+        return unknown;
+    }
+
+    // number of tokens before the first option
+    size_t positionalArguments() const {
+        size_t pos = 0;
+        while (hasToken(pos) && isParameterAt(pos))
+            ++pos;
+        return pos;
+    }
+
+    // flag without leading dashes
+    String configKey(const String& flag) const {
+        size_t dashes = std::min(flag.find_first_not_of('-'), flag.size());
+        return String(flag.data() + dashes, flag.size() - dashes, alloc);
+    }
+
+    // declaration of an option by its flag
+    const std::pair<const String, std::pair<String, String>>* optionOf(const String& flag) const {
+        for (auto& group : schema->optionGroups) {
+            auto itr = group.options.find(flag);
+            if (itr != group.options.end())
+                return &*itr;
+        }
+        return nullptr;
+    }
+
+    // position of the parameter of an option, npos if there is none
+    size_t findParameter(ArgView option) const {
+        size_t pos = findToken(option);
+        return (pos != npos && parametersOf(pos) > 0) ? pos + 1 : npos;
+    }
+
+    // validator of an option given as flag or alternative
+    const Validator* findValidator(ArgView option) const {
+        for (auto& group : schema->optionGroups) {
+            for (auto& v : group.validators) {
+                const String& alternative = group.options.find(v.first)->second.second;
+                if (option == v.first.c_str() || (!alternative.empty() && option == alternative.c_str()))
+                    return &v.second;
+            }
+        }
+        return nullptr;
+    }
+
+    // default of an option given as flag or alternative, nullptr if there is none or the option has a parameter
+    const DefaultValue* findDefault(ArgView option) const {
+        std::int32_t id = declaredOption(option);
+        return (id >= 0 && schema->optionDefaults[id].exists() && !hasParameter(id)) ? &schema->optionDefaults[id] : nullptr;
+    }
+
+    // whether the flag or the alternative of the declared option has a parameter, then its fallbacks don't apply
+    bool hasParameter(std::int32_t option) const {
+        const String& alternative = schema->optionNames[option].second;
+        return findParameter(schema->optionNames[option].first) != npos || (!alternative.empty() && findParameter(alternative) != npos);
+    }
+
+    // value of the environment variable bound to an option given as flag or alternative, one lookup in the snapshot,
+    // nullptr if there is none or the option has a parameter
+    const String* findEnvironmentValue(ArgView option) const {
+        std::int32_t id = declaredOption(option);
+        if (id < 0 || schema->optionVariables[id].empty() || hasParameter(id))
+            return nullptr;
+        auto itr = environment().find(schema->optionVariables[id]);
+        return itr != environment().end() ? &itr->second : nullptr;
+    }
+
+    // snapshot of the environment, indexed once on first use
+    const minicmd::HashMap<Allocator, String, String>& environment() const {
+        if (!environmentIndexed) {
+            for (char** variable = MINICMD_ENVIRON; variable != nullptr && *variable != nullptr; ++variable) {
+                const char* equal = std::strchr(*variable, '=');
+                if (equal != nullptr)
+                    environmentIndex.insert(std::make_pair(String(*variable, equal - *variable, alloc), String(equal + 1, alloc)));
+            }
+            environmentIndexed = true;
+        }
+        return environmentIndex;
+    }
+
+    bool hasToken(size_t pos) const {
+        while (pos >= tokens.size() && tokenizeNext()) {}
+        return pos < tokens.size();
+    }
+
+    bool unixFlags;
+    int argc;
+    char const*const* argv;
+    mutable int nextArg;
+    Allocator alloc;
+    Status state;
+    mutable String text;  // the tokens, each followed by '\0', most of them in place in copies of the arguments
+    mutable minicmd::Vector<Allocator, Token> tokens;
+    mutable minicmd::Vector<Allocator, std::uint64_t> tokenHashes;  // hash of each token, computed while tokenizing
+    mutable minicmd::Vector<Allocator, bool> splitTokens;  // whether each token was split off its argument before an =
+    mutable minicmd::Vector<Allocator, int> tokenOrigins;  // argv index of tokens that are a whole argv element, or -1
+    mutable minicmd::Vector<Allocator, size_t> indexSlots;  // open addressing table of the first occurrence of each token, npos if empty
+    mutable size_t numIndexed;
+    mutable Token sortedIndex;  // of a deserialized MiniCommander until tokens are added, the positions in the index of the blob
+    minicmd::Map<Allocator, String, String> subcommands;  // name -> description
+    String invokedSubcommand;
+    mutable bool environmentIndexed;
+    mutable minicmd::HashMap<Allocator, String, String> environmentIndex;  // variable -> value
+    mutable std::shared_ptr<Schema> schema;  // shared read-only once it's compiled, copied before it's changed then
+    mutable bool schemaDirty;  // the schema changed since the tokens were classified
+    bool abbreviations;
+    mutable bool ambiguousAbbreviation;
+    bool strict;
+    bool allowPositionals;
+    mutable minicmd::Vector<Allocator, TokenKind> kinds;  // of the tokens classified since the options were compiled
+    mutable size_t numUnknown;
+    mutable minicmd::Vector<Allocator, size_t> numParameters;  // of each classified flag
+    mutable minicmd::Vector<Allocator, size_t> positionals;  // positions of the positional arguments
+    mutable Classification classification;
+    mutable minicmd::Vector<Allocator, MapEntry> mapEntries;
+    mutable size_t numMapEntries;
+    mutable size_t operandsBegin;  // position of the first token after the -- terminator, npos without one
+    mutable size_t operandsEnd;
+};
+
+typedef BasicMiniCommander<> MiniCommander;
+
+// holds an immutable, validated snapshot of parsed options, reload() parses a new snapshot, e.g. after SIGHUP
+// or a change of the config file, and publishes it with an atomic pointer exchange. Readers take no lock:
+// snapshot() counts the reader in and loads the pointer, both plain atomic operations, and superseded snapshots
+// are freed by the next reload() that finds no reader counted in, or by the destructor
+template<class Commander = MiniCommander>
+class ReloadableCommander {
+public:
+    // parse returns a new Commander with its option groups added and config loaded, or nullptr on failure
+    typedef std::function<std::unique_ptr<Commander>()> Parser;
+
+    // pins a snapshot, which stays valid until the Snapshot is destroyed
+    class Snapshot {
+    public:
+        Snapshot(Snapshot&& other) noexcept : commander(other.commander), readers(other.readers) {
+            other.readers = nullptr;
+        }
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        ~Snapshot() {
+            if (readers != nullptr)
+                readers->fetch_sub(1, std::memory_order_release);
+        }
+
+        const Commander* get() const noexcept { return commander; }
+        const Commander* operator->() const noexcept { return commander; }
+        const Commander& operator*() const noexcept { return *commander; }
+        explicit operator bool() const noexcept { return commander != nullptr; }
+
+    private:
+        friend class ReloadableCommander;
+        Snapshot(const Commander* commander, std::atomic<size_t>* readers) noexcept
+            : commander(commander), readers(readers) {}
+
+        const Commander* commander;
+        std::atomic<size_t>* readers;  // nullptr once moved from
+    };
+
+    explicit ReloadableCommander(const Parser& parse) MINICMD_NOEXCEPT : parse(parse), current(nullptr), readers(0) {
+        reload();
+    }
+    ReloadableCommander(const ReloadableCommander&) = delete;
+    ReloadableCommander& operator=(const ReloadableCommander&) = delete;
+
+    // no Snapshot may outlive it
+    ~ReloadableCommander() {
+        delete current.load();
+        for (const Commander* commander : retired)
+            delete commander;
+    }
+
+    // publishes a new snapshot if it could be parsed and passes checkFlags, otherwise keeps the current one,
+    // concurrent reloads are serialized, readers are never blocked
+    bool reload() MINICMD_NOEXCEPT {
+        std::unique_ptr<Commander> next = parse();
+        if (!next || !next->checkFlags())
+            return false;
+        next->freeze();
+        std::lock_guard<std::mutex> lock(writer);
+        if (const Commander* superseded = current.exchange(next.release()))
+            retired.push_back(superseded);
+        // a reader counted in after this load sees the new snapshot, so without readers none can hold a retired one
+        if (readers.load() == 0) {
+            for (const Commander* commander : retired)
+                delete commander;
+            retired.clear();
+        }
+        return true;
+    }
+
+    // current snapshot, empty if there was no valid one yet
+    Snapshot snapshot() const noexcept {
+        readers.fetch_add(1);  // sequentially consistent, so it's ordered before the load
+        return Snapshot(current.load(), &readers);
+    }
+
+    // whether the atomics of snapshot() are lock-free on this platform, i.e. don't fall back to a lock
+    bool isLockFree() const noexcept {
+        return current.is_lock_free() && readers.is_lock_free();
+    }
+
+private:
+    Parser parse;
+    std::atomic<const Commander*> current;
+    mutable std::atomic<size_t> readers;  // Snapshots alive
+    std::mutex writer;  // serializes reloads
+    std::vector<const Commander*> retired;  // superseded snapshots readers may still hold
+};
+
+struct StaticOption {
+    const char* flag;
+    const char* description;
+    const char* alternativeFlag;
+};
+
+template<size_t MaxOptions>
+struct StaticOptionGroup {
+    Policy policy;
+    const char* groupDescription;
+    StaticOption options[MaxOptions];
+    size_t size;
+    StaticOptionGroup(Policy p, const char* description) noexcept : policy(p), groupDescription(description), size(0) {}
+    Status addOption(const char* flag, const char* desc = "", const char* alternativeFlag = "") noexcept {
+        if (size == MaxOptions)
+            return Status::tooManyOptions;
+        options[size++] = StaticOption{flag, desc, alternativeFlag};
+        return Status::ok;
+    }
+};
+
+// allocation-free variant of MiniCommander with fixed capacities,
+// tokens are views into argv which must outlive the StaticCommander
+template<size_t MaxTokens, size_t MaxOptions>
+class StaticCommander {
+public:
+    StaticCommander(const int argc, char const*const* argv, bool unixFlags=false) noexcept
+        : unixFlags(unixFlags), numTokens(0), numOptions(0), numGroups(0), state(Status::ok) {
+        for (int i = 1; i < argc; ++i)
+            minicmd::splitArgument(argv[i], unixFlags, [this](ArgView token, bool) { addToken(token); });
+    }
+
+    // first overflow that occurred, tokens or options beyond the capacity are dropped
+    Status status() const noexcept {
+        return state;
+    }
+
+    template<size_t N>
+    Status addOptionGroup(const StaticOptionGroup<N>& group) noexcept {
+        if (numGroups == MaxOptions || numOptions + group.size > MaxOptions)
+            return fail(Status::tooManyOptions);
+        groups[numGroups++] = Group{group.policy, group.groupDescription, numOptions, group.size};
+        for (size_t o = 0; o < group.size; ++o)
+            options[numOptions++] = group.options[o];
+        return Status::ok;
+    }
+
+    bool checkFlags() const noexcept {
+        for (size_t g = 0; g < numGroups; ++g) {
+            const Group& group = groups[g];
+            size_t numGiven = 0;
+            for (size_t o = group.first; o < group.first + group.count; ++o) {
+                bool given = optionExists(options[o].flag) || optionExists(options[o].alternativeFlag);
+                if (group.policy == Policy::required && !given)
+                    return false;
+                numGiven += given;
+            }
+            if (group.count > 0 && (((group.policy == Policy::anyOf || group.policy == Policy::exactlyOne) && numGiven == 0) ||
+                                    ((group.policy == Policy::exactlyOne || group.policy == Policy::atMostOne) && numGiven > 1)))
+                return false;
+        }
+        return true;
+    }
+
+    void printHelpMessage(const char* title = "\nUSAGE") const noexcept {
+        std::fprintf(stderr, "%s\n", title);
+        for (size_t g = 0; g < numGroups; ++g) {
+            std::fprintf(stderr, "\n[%s]\n", groups[g].description);
+            for (size_t o = groups[g].first; o < groups[g].first + groups[g].count; ++o)
+                std::fprintf(stderr, "%s %s\t%s\n", options[o].flag, options[o].alternativeFlag, options[o].description);
+        }
+    }
+
+    ArgView getParameter(const char* option) const noexcept {
+        size_t pos = findToken(option);
+        return (pos + 1 < numTokens && !isOption(tokens[pos + 1])) ? tokens[pos + 1] : ArgView();
+    }
+
+    ArgRange getMultiParameters(const char* option) const noexcept {
+        size_t pos = findToken(option);
+        size_t end = (pos < numTokens) ? pos + 1 : numTokens;
+        while (end < numTokens && !isOption(tokens[end]))
+            ++end;
+        return (pos < numTokens) ? ArgRange{tokens + pos + 1, end - pos - 1} : ArgRange{tokens, 0};
+    }
+
+    bool optionExists(const char* option) const noexcept {
+        return findToken(option) < numTokens;
+    }
+
+private:
+    struct Group {
+        Policy policy;
+        const char* description;
+        size_t first;
+        size_t count;
+    };
+
+    Status fail(Status status) {
+        if (state == Status::ok)
+            state = status;
+        return status;
+    }
+
+    void addToken(const ArgView& token) {
+        if (numTokens == MaxTokens)
+            fail(Status::tooManyTokens);
+        else
+            tokens[numTokens++] = token;
+    }
+
+    size_t findToken(const char* token) const {
+        size_t pos = 0;
+        while (pos < numTokens && !(tokens[pos] == token))
+            ++pos;
+        return pos;
+    }
+
+    bool isOption(const ArgView& str) const {
+        for (size_t o = 0; o < numOptions; ++o)
+            if (str == options[o].flag || str == options[o].alternativeFlag || (unixFlags && str.data[0] == '-')) return true;
         return false;
     }
 
     bool unixFlags;
-    std::vector<std::string> tokens;
-    std::vector<OptionGroup> optionGroups;
+    ArgView tokens[MaxTokens];
+    size_t numTokens;
+    StaticOption options[MaxOptions];
+    size_t numOptions;
+    Group groups[MaxOptions];
+    size_t numGroups;
+    Status state;
 };
 
 #endif  // MINICMD
\ No newline at end of file
@@ -0,0 +1,423 @@
+// benchmarks for MiniCommander.hpp
+// author: Michael Grupp
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#ifdef __linux__
+#include <thread>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "MiniCommander.hpp"
+
+using namespace std;
+
+// counts global heap allocations, all forms of the global operators are replaced consistently and
+// forward to allocate/deallocate out of line, so the compiler doesn't match inlined free() calls against new
+static size_t heapAllocations = 0;
+
+#if defined(__GNUC__)
+#define BENCHMARK_NOINLINE __attribute__((noinline))
+#else
+#define BENCHMARK_NOINLINE
+#endif
+
+BENCHMARK_NOINLINE static void* allocate(size_t size) {
+    ++heapAllocations;
+    if (void* memory = malloc(size ? size : 1))
+        return memory;
+    throw bad_alloc();
+}
+
+BENCHMARK_NOINLINE static void deallocate(void* memory) noexcept {
+    free(memory);
+}
+
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+void operator delete(void* memory) noexcept { deallocate(memory); }
+void operator delete[](void* memory) noexcept { deallocate(memory); }
+void operator delete(void* memory, size_t) noexcept { deallocate(memory); }
+void operator delete[](void* memory, size_t) noexcept { deallocate(memory); }
+
+// runs f a number of times, prints the time and global heap allocations per run and returns the time
+template<class F>
+double benchmark(const string& name, size_t runs, F f) {
+    size_t allocationsBefore = heapAllocations;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < runs; ++i)
+        f();
+    auto end = chrono::steady_clock::now();
+    double us = chrono::duration<double, micro>(end - start).count() / runs;
+    double allocations = double(heapAllocations - allocationsBefore) / runs;
+    cout << name << ": " << us << " us, " << allocations << " heap allocations per run" << endl;
+    return us;
+}
+
+// parses args and queries all options, returns a checksum so the work isn't optimized out
+template<class Allocator>
+size_t parse(const vector<const char*>& args, const Allocator& alloc) {
+    BasicMiniCommander<Allocator> cmd((int)args.size(), args.data(), true, false, alloc);
+    BasicOptionGroup<Allocator> required(Policy::required, "required parameters", alloc);
+    required.addOption("-d", "path to a dataset folder", "--data");
+    required.addOption("-f", "path to one or multiple files", "--files");
+    BasicOptionGroup<Allocator> formats(Policy::anyOf, "formats, choose one or more", alloc);
+    formats.addOption("-x", "use x format");
+    formats.addOption("-y", "use y format");
+    formats.addOption("-z", "use z format");
+    cmd.addOptionGroup(required);
+    cmd.addOptionGroup(formats);
+    return cmd.checkFlags() + cmd.getParameter("--data").size() + cmd.getMultiParameters("--files").size();
+}
+
+void benchmarkAllocators() {
+    vector<const char*> args = {"appname", "-xyz", "--data=/data/a/rather/long/path/to/the/dataset"};
+    args.push_back("--files");
+    vector<string> files;
+    for (int i = 0; i < 100; ++i)
+        files.push_back("/data/a/rather/long/path/to/file_" + to_string(i) + ".txt");
+    for (auto& f : files)
+        args.push_back(f.c_str());
+
+    const size_t runs = 2000;
+    size_t checksum = 0;
+    benchmark("parse with std::allocator", runs, [&]() {
+        checksum += parse(args, allocator<char>());
+    });
+    static char buffer[1 << 16];
+    benchmark("parse with monotonic arena", runs, [&]() {
+        MonotonicArena arena(buffer, sizeof(buffer));
+        checksum += parse(args, ArenaAllocator<char>(arena));
+    });
+    cout << "(checksum " << checksum << ")" << endl;
+}
+
+void benchmarkCanonicalForm() {
+    string line = "appname -xyz --data=/data/a/rather/long/path/to/the/dataset --files";
+    for (int i = 0; i < 100; ++i)
+        line += " /data/a/rather/long/path/to/file_" + to_string(i) + ".txt";
+    OptionGroup required(Policy::required, "required parameters");
+    required.addOption("-d", "path to a dataset folder", "--data");
+    required.addOption("-f", "path to one or multiple files", "--files");
+    OptionGroup formats(Policy::anyOf, "formats, choose one or more");
+    formats.addOption("-x", "use x format");
+    formats.addOption("-y", "use y format");
+    formats.addOption("-z", "use z format");
+    MiniCommander cmd(line, true);
+    cmd.addOptionGroup(required);
+    cmd.addOptionGroup(formats);
+
+    const size_t runs = 2000;
+    size_t checksum = 0;
+    benchmark("canonical arguments", runs, [&]() {
+        checksum += cmd.canonicalArguments().size();
+    });
+    benchmark("canonical hash", runs, [&]() {
+        checksum += cmd.canonicalHash();
+    });
+    string data = cmd.serialize();
+    benchmark("parse again", runs, [&]() {
+        MiniCommander again(line, true);
+        checksum += again.optionExists("-z");
+    });
+    benchmark("deserialize " + to_string(data.size()) + " bytes", runs, [&]() {
+        MiniCommander restored = MiniCommander::deserialize(data);
+        checksum += restored.optionExists("-z");
+    });
+    benchmark("deserialize a view of it", runs, [&]() {
+        MiniCommander restored = MiniCommander::deserializeView(data);
+        checksum += restored.optionExists("-z");
+    });
+    cout << "(checksum " << checksum << ")" << endl;
+}
+
+void benchmarkCommandLine() {
+    // multi-MB command line with mostly plain words and some quoted or escaped ones
+    string line = "appname";
+    for (int i = 0; line.size() < (8 << 20); ++i) {
+        line += " --option_" + to_string(i % 100) + "=/some/path/to/a/file_" + to_string(i) + ".txt";
+        if (i % 10 == 0)
+            line += " 'a quoted parameter' \"a \\\"double\\\" quoted one\" an\\ escaped\\ one";
+    }
+    double megabytes = line.size() / double(1 << 20);
+
+    const size_t runs = 10;
+    size_t words = 0;
+    string scratch;
+    double us = benchmark("split " + to_string(megabytes) + " MB command line", runs, [&]() {
+        minicmd::splitCommandLine(ArgView(line), scratch, [&](ArgView) { ++words; });
+    });
+    cout << "  " << megabytes / us * 1e6 << " MB/s" << endl;
+    us = benchmark("construct MiniCommander from it", runs, [&]() {
+        MiniCommander cmd(line);
+        words += cmd.optionExists("--option_99");
+    });
+    cout << "  " << megabytes / us * 1e6 << " MB/s" << endl;
+    cout << "(words " << words << ")" << endl;
+}
+
+void benchmarkPrefixFamilies() {
+    // compiler command line with ~10k flags, checked against thousands of flag patterns
+    OptionGroup compiler(Policy::optional, "compiler options");
+    for (const char* family : {"-I*", "-isystem*", "-L*", "-l*", "-D*", "-U*", "-O*", "-W*", "-Wno-*", "-f*", "-fno-*", "-m*", "-g*"})
+        compiler.addOption(family, "prefix family");
+    for (int i = 0; i < 3000; ++i) {
+        compiler.addOption("-Wwarning-" + to_string(i), "warning");
+        compiler.addOption("-ffeature-" + to_string(i), "feature");
+    }
+    compiler.addOption("-c", "compile only");
+    compiler.addOption("-o", "output file");
+    string line = "c++ -c main.cpp -o main.o -O2 -g";
+    for (int i = 0; i < 10000; ++i) {
+        switch (i % 6) {
+        case 0: line += " -I/usr/include/project/module_" + to_string(i); break;
+        case 1: line += " -DDEFINE_" + to_string(i); break;
+        case 2: line += " -Wwarning-" + to_string(i % 3000); break;
+        case 3: line += " -Wno-unknown-" + to_string(i); break;
+        case 4: line += " -fno-feature-" + to_string(i); break;
+        case 5: line += " -L/usr/lib/project/module_" + to_string(i); break;
+        }
+    }
+
+    const size_t runs = 20;
+    size_t checksum = 0;
+    benchmark("parse 10k compiler flags against 6k patterns", runs, [&]() {
+        MiniCommander cmd(line);
+        cmd.addOptionGroup(compiler);
+        checksum += cmd.checkFlags() + cmd.getMultiParameters("-I*").size() + cmd.getMultiParameters("-c").size();
+    });
+    cout << "(checksum " << checksum << ")" << endl;
+}
+
+void benchmarkAbbreviations() {
+    // hundreds of long options, all given abbreviated
+    OptionGroup options(Policy::optional, "long options");
+    string line = "appname";
+    for (int i = 0; i < 500; ++i) {
+        string name = "--option-" + to_string(i) + "-with-a-long-name";
+        options.addOption(name, "long option");
+        line += " " + name.substr(0, name.find("-with") + 3) + " value_" + to_string(i);
+    }
+
+    const size_t runs = 100;
+    size_t checksum = 0;
+    benchmark("resolve 500 abbreviated long options", runs, [&]() {
+        MiniCommander cmd(line);
+        cmd.setAbbreviations(true);
+        cmd.addOptionGroup(options);
+        checksum += cmd.optionExists("--option-499-with-a-long-name") + (cmd.status() == Status::ok);
+    });
+    cout << "(checksum " << checksum << ")" << endl;
+}
+
+void benchmarkSuggestions() {
+    // closest of thousands of options to a mistyped one
+    OptionGroup options(Policy::optional, "options");
+    for (int i = 0; i < 5000; ++i)
+        options.addOption("--option-" + to_string(i) + "-name", "option");
+    MiniCommander cmd("appname --optoin-4242-nmae");
+    cmd.addOptionGroup(options);
+    cmd.freeze();
+
+    const size_t runs = 100;
+    size_t checksum = 0;
+    benchmark("suggest options among 5000", runs, [&]() {
+        checksum += cmd.suggestOptions(cmd.unknownOptions().front()).size();
+    });
+    cout << "(checksum " << checksum << ")" << endl;
+}
+
+void benchmarkArities() {
+    // options with many parameters each, most of them negative numbers
+    OptionGroup options(Policy::optional, "options");
+    string line = "appname";
+    for (int i = 0; i < 200; ++i) {
+        string name = "--values-" + to_string(i);
+        options.addOption(name, "values");
+        options.setArity(name, Arity::exactly(20));
+        line += " " + name;
+        for (int v = 0; v < 20; ++v)
+            line += " -" + to_string(v);
+    }
+
+    const size_t runs = 100;
+    size_t checksum = 0;
+    benchmark("query 200 options with 20 parameters each", runs, [&]() {
+        MiniCommander cmd(line, true);
+        cmd.addOptionGroup(options);
+        for (int i = 0; i < 200; ++i)
+            checksum += cmd.getMultiParameters("--values-" + to_string(i)).size();
+    });
+    cout << "(checksum " << checksum << ")" << endl;
+}
+
+void benchmarkValidators() {
+    // values checked against a regex and hundreds of choices
+    vector<string> names;
+    for (int i = 0; i < 500; ++i)
+        names.push_back("choice_" + to_string(i));
+    minicmd::PerfectHash choices(names);
+    OptionGroup options(Policy::optional, "options");
+    options.addOption("--id", "ticket id", "", DefaultValue(), Validator::pattern("[A-Z]+-[0-9]{1,5}").value);
+    options.addOption("--mode", "mode", "", DefaultValue(), Validator::choices({"fast", "safe", "paranoid"}));
+    MiniCommander cmd("appname --id ABC-123 --mode safe");
+    cmd.addOptionGroup(options);
+    cmd.freeze();
+
+    const size_t runs = 1000;
+    size_t checksum = 0;
+    benchmark("validate options", runs, [&]() {
+        checksum += cmd.validationErrors().size() + cmd.getChoice("--mode").value;
+    });
+    benchmark("look up 500 choices", runs, [&]() {
+        for (auto& name : names)
+            checksum += choices.find(name);
+    });
+    cout << "(checksum " << checksum << ")" << endl;
+}
+
+void benchmarkConstraints() {
+    // thousands of options, each requiring the previous one and conflicting with a disabled one
+    OptionGroup options(Policy::optional, "options");
+    OptionGroup disabled(Policy::atMostOne, "disabled options");
+    string line = "appname";
+    for (int i = 0; i < 5000; ++i) {
+        string name = "--option-" + to_string(i);
+        options.addOption(name, "option");
+        disabled.addOption("--no-option-" + to_string(i), "disabled option");
+        if (i > 0)
+            options.addRequirement(name, "--option-" + to_string(i - 1));
+        options.addConflict(name, "--no-option-" + to_string(i));
+        line += " " + name;
+    }
+    MiniCommander cmd(line);
+    cmd.addOptionGroup(options);
+    cmd.addOptionGroup(disabled);
+    cmd.freeze();
+
+    const size_t runs = 10;
+    size_t checksum = 0;
+    benchmark("check 10000 options with 10000 requirements and conflicts", runs, [&]() {
+        checksum += cmd.validationErrors().size() + 1;
+    });
+    cout << "(checksum " << checksum << ")" << endl;
+}
+
+void benchmarkMapOptions() {
+    // hundreds of -D name=value overrides, some of them repeated
+    OptionGroup options(Policy::optional, "options");
+    options.addMapOption("-D", "define a setting");
+    string line = "appname";
+    for (int i = 0; i < 1000; ++i)
+        line += " -D setting_" + to_string(i % 800) + "=value_" + to_string(i);
+    MiniCommander cmd(line);
+    cmd.addOptionGroup(options);
+    cmd.freeze();
+    vector<string> keys;
+    for (int i = 0; i < 800; ++i)
+        keys.push_back("setting_" + to_string(i));
+
+    const size_t runs = 100;
+    size_t checksum = 0;
+    benchmark("look up 800 map option keys", runs, [&]() {
+        for (auto& key : keys)
+            checksum += cmd.getMapValue("-D", key).value.size;
+    });
+    cout << "(checksum " << checksum << ")" << endl;
+}
+
+void benchmarkFallbacks() {
+    // thousands of options with defaults or bound to environment variables, half of them given on the command line
+    OptionGroup options(Policy::optional, "options");
+    string line = "appname";
+    vector<string> flags;
+    for (int i = 0; i < 4000; ++i) {
+        flags.push_back("--option-" + to_string(i));
+        if (i % 4 == 2) {
+            options.addOption(flags.back(), "option", "", to_string(i));
+        } else {
+            options.addOption(flags.back(), "option");
+            options.addEnvironmentVariable(flags.back(), i % 4 == 0 ? "HOME" : "MINICMD_BENCHMARK_" + to_string(i));
+        }
+        if (i % 2 == 1)
+            line += " " + flags.back() + " " + to_string(i);
+    }
+    MiniCommander cmd(line);
+    cmd.addOptionGroup(options);
+    cmd.freeze();
+
+    const size_t runs = 10;
+    size_t checksum = 0;
+    benchmark("get 4000 options falling back to the environment or defaults", runs, [&]() {
+        for (auto& flag : flags)
+            checksum += cmd.getParameter(flag).size();
+    });
+    cout << "(checksum " << checksum << ")" << endl;
+}
+
+#ifdef __linux__
+void benchmarkProcessScan() {
+    // /proc-like directory with thousands of processes
+    string root = "/tmp/minicmd_benchmark_proc";
+    mkdir(root.c_str(), 0755);
+    const long processes = 5000;
+    for (long pid = 1; pid <= processes; ++pid) {
+        string dir = root + "/" + to_string(pid);
+        mkdir(dir.c_str(), 0755);
+        ofstream cmdline(dir + "/cmdline", ios::binary);
+        cmdline << "appname" << '\0' << (pid % 3 ? "-x" : "-y") << '\0' << "--data=/data/" << pid << '\0';
+        for (int i = 0; i < 20; ++i)
+            cmdline << "/data/a/rather/long/path/to/file_" << i << ".txt" << '\0';
+    }
+
+    OptionGroup formats(Policy::anyOf, "formats, choose one or more");
+    formats.addOption("-x", "use x format");
+    formats.addOption("-y", "use y format");
+    vector<OptionGroup> schema = {formats};
+    size_t matches = 0;
+    unsigned cores = max(1u, thread::hardware_concurrency());
+    for (unsigned threads : {1u, cores}) {
+        double us = benchmark("scan " + to_string(processes) + " processes on " + to_string(threads) + " threads", 3, [&]() {
+            auto results = MiniCommander::scanProcesses(schema, [](const MiniCommander& cmd) {
+                return cmd.optionExists("-x");
+            }, root, threads);
+            for (auto& r : results)
+                matches += r.second;
+        });
+        cout << "  " << processes / us * 1e6 << " processes/s" << endl;
+    }
+    cout << "(matches " << matches << ")" << endl;
+
+    for (long pid = 1; pid <= processes; ++pid) {
+        string dir = root + "/" + to_string(pid);
+        std::remove((dir + "/cmdline").c_str());
+        rmdir(dir.c_str());
+    }
+    rmdir(root.c_str());
+}
+#endif
+
+int main()
+{
+    benchmarkAllocators();
+    benchmarkCommandLine();
+    benchmarkCanonicalForm();
+    benchmarkPrefixFamilies();
+    benchmarkAbbreviations();
+    benchmarkSuggestions();
+    benchmarkArities();
+    benchmarkValidators();
+    benchmarkConstraints();
+    benchmarkMapOptions();
+    benchmarkFallbacks();
+#ifdef __linux__
+    benchmarkProcessScan();
+#endif
+    return EXIT_SUCCESS;
+}
@@ -3,8 +3,20 @@
 
 #include <array>
 #include <chrono>
+#include <atomic>
+#include <thread>
 #include <regex>
 #include <iostream>
+#include <fstream>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#endif
+#if __cplusplus >= 201703L
+#include <memory_resource>
+#endif
 
 #include <gtest/gtest.h>
 
@@ -13,35 +25,63 @@
 using namespace std;
 
 
-class MiniCommanderTest : public ::testing::Test {
+template<class Commander>
+struct CommanderTraits {
+    typedef OptionGroup Group;
+};
+
+template<size_t MaxTokens, size_t MaxOptions>
+struct CommanderTraits<StaticCommander<MaxTokens, MaxOptions>> {
+    typedef StaticOptionGroup<MaxOptions> Group;
+};
+
+template<class Commander>
+class CommanderTest : public ::testing::Test {
 protected:
+    typedef typename CommanderTraits<Commander>::Group Group;
     void SetUp(int argc, char const* const* argv, bool unixFlags=false) {
-        mc = new MiniCommander(argc, argv, unixFlags);
+        mc = new Commander(argc, argv, unixFlags);
     }
     void TearDown() {
         delete mc;
     }
-    MiniCommander* mc;
+    Commander* mc;
 };
 
-vector<OptionGroup> makeTestOptionGroups() {
-    OptionGroup required(Policy::required, "required parameters");
+// all tests of the CommanderTest case run against each of these implementations
+typedef ::testing::Types<MiniCommander, StaticCommander<32, 16>> Commanders;
+TYPED_TEST_CASE(CommanderTest, Commanders);
+
+// for tests of MiniCommander-only features
+typedef CommanderTest<MiniCommander> MiniCommanderTest;
+
+template<class Group = OptionGroup>
+vector<Group> makeTestOptionGroups() {
+    Group required(Policy::required, "required parameters");
     required.addOption("-d", "path to a dataset folder", "--data");
     required.addOption("-f", "path to one or multiple files", "--files");
-    OptionGroup switches(Policy::anyOf, "switches, choose one");
+    Group switches(Policy::anyOf, "switches, choose one");
     switches.addOption("--do_this");
     switches.addOption("--do_that");
-    OptionGroup formats(Policy::anyOf, "formats, choose one or more");
+    Group formats(Policy::anyOf, "formats, choose one or more");
     formats.addOption("-x", "use x format");
     formats.addOption("-y", "use y format");
     formats.addOption("-z", "use z format");
-    OptionGroup optionals(Policy::optional, "optional parameters");
+    Group optionals(Policy::optional, "optional parameters");
     optionals.addOption("-a", "activate something");
     optionals.addOption("--help", "show info and usage");
-    std::vector<OptionGroup> optionGroups = {required, switches, formats, optionals};
+    std::vector<Group> optionGroups = {required, switches, formats, optionals};
     return optionGroups;
 }
 
+// registered options, as libraries would define them
+MINICMD_FLAG(bool, verbose, "--verbose", false, "verbose output");
+MINICMD_FLAG(bool, color, "--color", true, "colored output");
+MINICMD_FLAG(int, jobs, "--jobs", 1, "number of jobs");
+MINICMD_FLAG(double, ratio, "--ratio", 0.5, "some ratio");
+MINICMD_FLAG(std::string, cache, "--cache", "/tmp/cache", "cache directory");
+MINICMD_FLAG(long, limit, "--limit", 100, "some limit");
+
 // quick hack for printing args
 std::string print(int argc, char const*const* argv) {
     std::string str = "";
@@ -52,257 +92,1654 @@ std::string print(int argc, char const*const* argv) {
     return str;
 }
 
-TEST_F(MiniCommanderTest, testCheckFlags_correct) {
+TYPED_TEST(CommanderTest, testCheckFlags_correct) {
     // passing correct flags for flags from makeTestOptionGroups
     const int argc = 7;
     array<const char*, argc> argv_std = {"appname", "-d", "/data/dataset", "-f", "file1.txt", "-x", "--do_that"};
     char const* const* argv = (char const* const*)argv_std.data();
-    SetUp(argc, argv);
-    auto optionGroups = makeTestOptionGroups();
+    this->SetUp(argc, argv);
+    auto optionGroups = makeTestOptionGroups<typename TestFixture::Group>();
     for (auto& g : optionGroups)
-        mc->addOptionGroup(g);
-    EXPECT_EQ(mc->checkFlags(), true) << "failed with argv: " << print(argc, argv);
+        this->mc->addOptionGroup(g);
+    EXPECT_EQ(this->mc->checkFlags(), true) << "failed with argv: " << print(argc, argv);
 }
 
-TEST_F(MiniCommanderTest, testCheckFlags_wrong) {
+TYPED_TEST(CommanderTest, testCheckFlags_wrong) {
     // missing flags for flags from makeTestOptionGroups
     const int argc = 6;
     array<const char*, argc> argv_std = {"appname", "-d", "/data/dataset", "-f", "file1.txt", "-x"};
     char const* const* argv = (char const* const*)argv_std.data();
-    SetUp(argc, argv);
-    auto optionGroups = makeTestOptionGroups();
+    this->SetUp(argc, argv);
+    auto optionGroups = makeTestOptionGroups<typename TestFixture::Group>();
     for (auto& g : optionGroups)
-        mc->addOptionGroup(g);
-    EXPECT_EQ(mc->checkFlags(), false) << "failed with argv: " << print(argc, argv);
+        this->mc->addOptionGroup(g);
+    EXPECT_EQ(this->mc->checkFlags(), false) << "failed with argv: " << print(argc, argv);
 }
 
-TEST_F(MiniCommanderTest, testParameter) {
+TYPED_TEST(CommanderTest, testParameter) {
     // test if a parameter can be passed after a flag
     const int argc = 7;
     array<const char*, argc> argv_std = {"appname", "-d", "/data/dataset", "-f", "file1.txt", "-y", "--do_this"};
     char const* const* argv = (char const* const*)argv_std.data();
-    SetUp(argc, argv);
-    auto optionGroups = makeTestOptionGroups();
+    this->SetUp(argc, argv);
+    auto optionGroups = makeTestOptionGroups<typename TestFixture::Group>();
     for (auto& g : optionGroups)
-        mc->addOptionGroup(g);
-    EXPECT_EQ(mc->checkFlags(), true) << "failed with argv: " << print(argc, argv);
-    string param = mc->getParameter("-d").c_str();
+        this->mc->addOptionGroup(g);
+    EXPECT_EQ(this->mc->checkFlags(), true) << "failed with argv: " << print(argc, argv);
+    string param = this->mc->getParameter("-d");
     ASSERT_STREQ(param.c_str(), "/data/dataset");
 }
 
-TEST_F(MiniCommanderTest, testMissingParameter) {
+TYPED_TEST(CommanderTest, testMissingParameter) {
     // test if an empty string is returned when a parameter is not given
     const int argc = 6;
     array<const char*, argc> argv_std = {"appname", "-d", "-f", "file1.txt", "-y", "--do_this"};
     char const* const* argv = (char const* const*)argv_std.data();
-    SetUp(argc, argv);
-    auto optionGroups = makeTestOptionGroups();
+    this->SetUp(argc, argv);
+    auto optionGroups = makeTestOptionGroups<typename TestFixture::Group>();
     for (auto& g : optionGroups)
-        mc->addOptionGroup(g);
-    EXPECT_EQ(mc->checkFlags(), true) << "failed with argv: " << print(argc, argv);
-    string param = mc->getParameter("-d").c_str();
+        this->mc->addOptionGroup(g);
+    EXPECT_EQ(this->mc->checkFlags(), true) << "failed with argv: " << print(argc, argv);
+    string param = this->mc->getParameter("-d");
     ASSERT_STREQ(param.c_str(), "");
 }
 
-TEST_F(MiniCommanderTest, testEqualParameter) {
+TYPED_TEST(CommanderTest, testEqualParameter) {
     // test if a parameter can be passed directly after a flag with an equal sign
     const int argc = 6;
     array<const char*, argc> argv_std = {"appname", "-d=/data/dataset", "-f", "file1.txt", "-z", "--do_this"};
     char const* const* argv = (char const* const*)argv_std.data();
-    SetUp(argc, argv);
-    auto optionGroups = makeTestOptionGroups();
+    this->SetUp(argc, argv);
+    auto optionGroups = makeTestOptionGroups<typename TestFixture::Group>();
     for (auto& g : optionGroups)
-        mc->addOptionGroup(g);
-    EXPECT_EQ(mc->checkFlags(), true) << "failed with argv: " << print(argc, argv);
-    string param = mc->getParameter("-d");
+        this->mc->addOptionGroup(g);
+    EXPECT_EQ(this->mc->checkFlags(), true) << "failed with argv: " << print(argc, argv);
+    string param = this->mc->getParameter("-d");
     ASSERT_STREQ(param.c_str(), "/data/dataset");
 }
 
-TEST_F(MiniCommanderTest, testMissingEqualParameter) {
+TYPED_TEST(CommanderTest, testMissingEqualParameter) {
     // test if an empty string is returned when a parameter is not given
     const int argc = 6;
     array<const char*, argc> argv_std = {"appname", "-d=", "-f", "file1.txt", "-y", "--do_this"};
     char const* const* argv = (char const* const*)argv_std.data();
-    SetUp(argc, argv);
-    auto optionGroups = makeTestOptionGroups();
+    this->SetUp(argc, argv);
+    auto optionGroups = makeTestOptionGroups<typename TestFixture::Group>();
     for (auto& g : optionGroups)
-        mc->addOptionGroup(g);
-    EXPECT_EQ(mc->checkFlags(), true) << "failed with argv: " << print(argc, argv);
-    string param = mc->getParameter("-d");
+        this->mc->addOptionGroup(g);
+    EXPECT_EQ(this->mc->checkFlags(), true) << "failed with argv: " << print(argc, argv);
+    string param = this->mc->getParameter("-d");
     ASSERT_STREQ(param.c_str(), "");
 }
 
-TEST_F(MiniCommanderTest, testMultiParameters) {
+TYPED_TEST(CommanderTest, testMultiParameters) {
     // test if multiple parameters are handled correctly
     const int argc = 8;
     array<const char*, argc> argv_std = {"appname", "-d=/data/dataset",
                                          "-f", "first.txt", "second.txt", "third.txt",
                                          "-y", "--do_this"};
     char const* const* argv = (char const* const*)argv_std.data();
-    SetUp(argc, argv);
-    auto optionGroups = makeTestOptionGroups();
+    this->SetUp(argc, argv);
+    auto optionGroups = makeTestOptionGroups<typename TestFixture::Group>();
     for (auto& g : optionGroups)
-        mc->addOptionGroup(g);
-    EXPECT_EQ(mc->checkFlags(), true) << "failed with argv: " << print(argc, argv);
-    string param = mc->getParameter("-d");
+        this->mc->addOptionGroup(g);
+    EXPECT_EQ(this->mc->checkFlags(), true) << "failed with argv: " << print(argc, argv);
+    string param = this->mc->getParameter("-d");
     ASSERT_STREQ(param.c_str(), "/data/dataset");
-    vector<string> params = mc->getMultiParameters("-f");
+    auto params = this->mc->getMultiParameters("-f");
     ASSERT_TRUE(params.size() == 3) << "actual size is: " << param.size() << "\nfailed with argv: " << print(argc, argv);
-    ASSERT_STREQ(params[0].c_str(), "first.txt") << "failed with argv: " << print(argc, argv);
-    ASSERT_STREQ(params[1].c_str(), "second.txt") << "failed with argv: " << print(argc, argv);
-    ASSERT_STREQ(params[2].c_str(), "third.txt") << "failed with argv: " << print(argc, argv);
+    ASSERT_EQ(string(params[0]), "first.txt") << "failed with argv: " << print(argc, argv);
+    ASSERT_EQ(string(params[1]), "second.txt") << "failed with argv: " << print(argc, argv);
+    ASSERT_EQ(string(params[2]), "third.txt") << "failed with argv: " << print(argc, argv);
 }
 
-TEST_F(MiniCommanderTest, testMissingMultiParameters) {
+TYPED_TEST(CommanderTest, testMissingMultiParameters) {
     // test if missing multiple parameters result in empty vector
     const int argc = 5;
     array<const char*, argc> argv_std = {"appname", "-d=/data/dataset", "-f", "-y", "--do_this"};
     char const* const* argv = (char const* const*)argv_std.data();
-    SetUp(argc, argv);
-    auto optionGroups = makeTestOptionGroups();
+    this->SetUp(argc, argv);
+    auto optionGroups = makeTestOptionGroups<typename TestFixture::Group>();
     for (auto& g : optionGroups)
-        mc->addOptionGroup(g);
-    EXPECT_EQ(mc->checkFlags(), true) << "failed with argv: " << print(argc, argv);
-    string param = mc->getParameter("-d");
+        this->mc->addOptionGroup(g);
+    EXPECT_EQ(this->mc->checkFlags(), true) << "failed with argv: " << print(argc, argv);
+    string param = this->mc->getParameter("-d");
     ASSERT_STREQ(param.c_str(), "/data/dataset");
-    vector<string> params = mc->getMultiParameters("-f");
+    auto params = this->mc->getMultiParameters("-f");
     ASSERT_TRUE(params.empty()) << "actual size is: " << param.size() << "\nfailed with argv: " << print(argc, argv);
 }
 
-TEST_F(MiniCommanderTest, testOptionExists) {
+TYPED_TEST(CommanderTest, testOptionExists) {
     // test if optionExists runs properly
     const int argc = 7;
     array<const char*, argc> argv_std = {"appname", "-d=/data/dataset", "-f", "file1.txt", "-y", "--do_this", "--help"};
     char const* const* argv = (char const* const*)argv_std.data();
-    SetUp(argc, argv);
-    auto optionGroups = makeTestOptionGroups();
+    this->SetUp(argc, argv);
+    auto optionGroups = makeTestOptionGroups<typename TestFixture::Group>();
     for (auto& g : optionGroups)
-        mc->addOptionGroup(g);
-    EXPECT_EQ(mc->checkFlags(), true) << "failed with argv: " << print(argc, argv);
-    EXPECT_TRUE(mc->optionExists("--help")) << "failed with argv: " << print(argc, argv);
-    EXPECT_FALSE(mc->optionExists("-a")) << "failed with argv: " << print(argc, argv);
+        this->mc->addOptionGroup(g);
+    EXPECT_EQ(this->mc->checkFlags(), true) << "failed with argv: " << print(argc, argv);
+    EXPECT_TRUE(this->mc->optionExists("--help")) << "failed with argv: " << print(argc, argv);
+    EXPECT_FALSE(this->mc->optionExists("-a")) << "failed with argv: " << print(argc, argv);
 }
 
-TEST_F(MiniCommanderTest, testNoArgs) {
+TYPED_TEST(CommanderTest, testNoArgs) {
     // test what happens when no option groups are added
     const int argc = 1;
     array<const char*, argc> argv_std = {"appname"};
     char const* const* argv = (char const* const*)argv_std.data();
-    SetUp(argc, argv);
-    EXPECT_EQ(mc->checkFlags(), true) << "failed with argv: " << print(argc, argv);
-    string param = mc->getParameter("-d");
+    this->SetUp(argc, argv);
+    EXPECT_EQ(this->mc->checkFlags(), true) << "failed with argv: " << print(argc, argv);
+    string param = this->mc->getParameter("-d");
     ASSERT_STREQ(param.c_str(), "");
-    vector<string> params = mc->getMultiParameters("-f");
+    auto params = this->mc->getMultiParameters("-f");
     ASSERT_TRUE(params.empty()) << "actual size is: " << param.size() << "\nfailed with argv: " << print(argc, argv);
-    EXPECT_FALSE(mc->optionExists("--help")) << "failed with argv: " << print(argc, argv);
-    EXPECT_FALSE(mc->optionExists("-a")) << "failed with argv: " << print(argc, argv);
+    EXPECT_FALSE(this->mc->optionExists("--help")) << "failed with argv: " << print(argc, argv);
+    EXPECT_FALSE(this->mc->optionExists("-a")) << "failed with argv: " << print(argc, argv);
 }
 
-TEST_F(MiniCommanderTest, testUnixOptionsCorrect) {
+TYPED_TEST(CommanderTest, testUnixOptionsCorrect) {
     // test Unix option behaviour, i.e. -xyz should be parsed like -x -y -z
     const int argc = 6;
     array<const char*, argc> argv_std = {"appname", "-d=/data/dataset", "-f", "file1.txt", "-xyz", "--do_this"};
     char const* const* argv = (char const* const*)argv_std.data();
     bool unixFlags = true;
-    SetUp(argc, argv, unixFlags);
-    auto optionGroups = makeTestOptionGroups();
+    this->SetUp(argc, argv, unixFlags);
+    auto optionGroups = makeTestOptionGroups<typename TestFixture::Group>();
     for (auto& g : optionGroups)
-        mc->addOptionGroup(g);
-    EXPECT_EQ(mc->checkFlags(), true) << "Unix option check failed with argv: " << print(argc, argv);
-    string param = mc->getParameter("-d");
+        this->mc->addOptionGroup(g);
+    EXPECT_EQ(this->mc->checkFlags(), true) << "Unix option check failed with argv: " << print(argc, argv);
+    string param = this->mc->getParameter("-d");
     ASSERT_STREQ(param.c_str(), "/data/dataset");
-    vector<string> params = mc->getMultiParameters("-f");
-    ASSERT_STREQ(params[0].c_str(), "file1.txt");
-    ASSERT_TRUE(mc->optionExists("-x"));
-    ASSERT_TRUE(mc->optionExists("-y"));
-    ASSERT_TRUE(mc->optionExists("-z"));
+    auto params = this->mc->getMultiParameters("-f");
+    ASSERT_EQ(string(params[0]), "file1.txt");
+    ASSERT_TRUE(this->mc->optionExists("-x"));
+    ASSERT_TRUE(this->mc->optionExists("-y"));
+    ASSERT_TRUE(this->mc->optionExists("-z"));
 }
 
-TEST_F(MiniCommanderTest, testUnixOptionsWrong) {
+TYPED_TEST(CommanderTest, testUnixOptionsWrong) {
     // test wrong Unix option behaviour, i.e. --xyz should NOT be parsed like -x -y -z
     // -fl param1 param2 with unknown option -l should not lead to params = -l param1 param2
     const int argc = 6;
     array<const char*, argc> argv_std = {"appname", "-xd=/data/dataset", "-fl", "file1.txt", "--yz", "--do_thisdo_that"};
     char const* const* argv = (char const* const*)argv_std.data();
     bool unixFlags = true;
-    SetUp(argc, argv, unixFlags);
-    auto optionGroups = makeTestOptionGroups();
+    this->SetUp(argc, argv, unixFlags);
+    auto optionGroups = makeTestOptionGroups<typename TestFixture::Group>();
     for (auto& g : optionGroups)
-        mc->addOptionGroup(g);
-    EXPECT_EQ(mc->checkFlags(), false) << "Unix option check failed with argv: " << print(argc, argv);
-    string param = mc->getParameter("-d");
+        this->mc->addOptionGroup(g);
+    EXPECT_EQ(this->mc->checkFlags(), false) << "Unix option check failed with argv: " << print(argc, argv);
+    string param = this->mc->getParameter("-d");
     ASSERT_STREQ(param.c_str(), "/data/dataset");
-    vector<string> params = mc->getMultiParameters("-f");
+    auto params = this->mc->getMultiParameters("-f");
     ASSERT_TRUE(params.empty());
-    ASSERT_TRUE(mc->optionExists("-x"));
-    ASSERT_FALSE(mc->optionExists("-y"));
-    ASSERT_FALSE(mc->optionExists("-z"));
-    ASSERT_FALSE(mc->optionExists("--do_this"));
-    ASSERT_FALSE(mc->optionExists("--do_that"));
+    ASSERT_TRUE(this->mc->optionExists("-x"));
+    ASSERT_FALSE(this->mc->optionExists("-y"));
+    ASSERT_FALSE(this->mc->optionExists("-z"));
+    ASSERT_FALSE(this->mc->optionExists("--do_this"));
+    ASSERT_FALSE(this->mc->optionExists("--do_that"));
 }
 
-TEST_F(MiniCommanderTest, testUnixOptionsWithEqualParam) {
+TYPED_TEST(CommanderTest, testUnixOptionsWithEqualParam) {
     // test what happens with -xyzd=/data/dataset
     const int argc = 5;
     array<const char*, argc> argv_std = {"appname", "-xyzd=/data/dataset", "-f", "file1.txt", "--do_this"};
     char const* const* argv = (char const* const*)argv_std.data();
     bool unixFlags = true;
-    SetUp(argc, argv, unixFlags);
-    auto optionGroups = makeTestOptionGroups();
+    this->SetUp(argc, argv, unixFlags);
+    auto optionGroups = makeTestOptionGroups<typename TestFixture::Group>();
     for (auto& g : optionGroups)
-        mc->addOptionGroup(g);
-    EXPECT_EQ(mc->checkFlags(), true) << "Unix option check failed with argv: " << print(argc, argv);
-    string param = mc->getParameter("-d");
+        this->mc->addOptionGroup(g);
+    EXPECT_EQ(this->mc->checkFlags(), true) << "Unix option check failed with argv: " << print(argc, argv);
+    string param = this->mc->getParameter("-d");
     ASSERT_STREQ(param.c_str(), "/data/dataset");
-    vector<string> params = mc->getMultiParameters("-f");
-    ASSERT_STREQ(params[0].c_str(), "file1.txt");
-    ASSERT_TRUE(mc->optionExists("-x"));
-    ASSERT_TRUE(mc->optionExists("-y"));
-    ASSERT_TRUE(mc->optionExists("-z"));
-    ASSERT_TRUE(mc->optionExists("--do_this"));
+    auto params = this->mc->getMultiParameters("-f");
+    ASSERT_EQ(string(params[0]), "file1.txt");
+    ASSERT_TRUE(this->mc->optionExists("-x"));
+    ASSERT_TRUE(this->mc->optionExists("-y"));
+    ASSERT_TRUE(this->mc->optionExists("-z"));
+    ASSERT_TRUE(this->mc->optionExists("--do_this"));
 }
 
-TEST_F(MiniCommanderTest, testUnixJunkParams) {
+TYPED_TEST(CommanderTest, testUnixJunkParams) {
     // some junk is passed
     const int argc = 6;
     array<const char*, argc> argv_std = {"appname", "-xyz=d=/data/dataset", "-f", "file1.txt", "--do_this", "-%271=da"};
     char const* const* argv = (char const* const*)argv_std.data();
     bool unixFlags = true;
-    SetUp(argc, argv, unixFlags);
-    auto optionGroups = makeTestOptionGroups();
+    this->SetUp(argc, argv, unixFlags);
+    auto optionGroups = makeTestOptionGroups<typename TestFixture::Group>();
     for (auto& g : optionGroups)
-        mc->addOptionGroup(g);
-    EXPECT_EQ(mc->checkFlags(), false) << "Unix option check failed with argv: " << print(argc, argv);
-    string param = mc->getParameter("-d");
+        this->mc->addOptionGroup(g);
+    EXPECT_EQ(this->mc->checkFlags(), false) << "Unix option check failed with argv: " << print(argc, argv);
+    string param = this->mc->getParameter("-d");
     ASSERT_STRNE(param.c_str(), "/data/dataset");
-    vector<string> params = mc->getMultiParameters("-f");
-    ASSERT_STREQ(params[0].c_str(), "file1.txt");
-    ASSERT_TRUE(mc->optionExists("-x"));
-    ASSERT_TRUE(mc->optionExists("-y"));
-    ASSERT_TRUE(mc->optionExists("-z"));
-    ASSERT_TRUE(mc->optionExists("--do_this"));
+    auto params = this->mc->getMultiParameters("-f");
+    ASSERT_EQ(string(params[0]), "file1.txt");
+    ASSERT_TRUE(this->mc->optionExists("-x"));
+    ASSERT_TRUE(this->mc->optionExists("-y"));
+    ASSERT_TRUE(this->mc->optionExists("-z"));
+    ASSERT_TRUE(this->mc->optionExists("--do_this"));
 }
 
-TEST_F(MiniCommanderTest, testAlternativeFlags) {
+TYPED_TEST(CommanderTest, testAlternativeFlags) {
     // test alternative flags as specified in their optionGroup
     const int argc = 7;
     array<const char*, argc> argv_std = {"appname", "-xyz", "--files", "f1", "f2", "--data=/data/dataset", "--do_this"};
     char const* const* argv = (char const* const*)argv_std.data();
     bool unixFlags = true;
-    SetUp(argc, argv, unixFlags);
+    this->SetUp(argc, argv, unixFlags);
+    auto optionGroups = makeTestOptionGroups<typename TestFixture::Group>();
+    for (auto& g : optionGroups)
+        this->mc->addOptionGroup(g);
+    EXPECT_EQ(this->mc->checkFlags(), true) << "Unix option check failed with argv: " << print(argc, argv);
+    string param = this->mc->getParameter("--data");
+    ASSERT_STREQ(param.c_str(), "/data/dataset");
+    auto params = this->mc->getMultiParameters("--files");
+    ASSERT_EQ(string(params[0]), "f1");
+    ASSERT_EQ(string(params[1]), "f2");
+    ASSERT_TRUE(this->mc->optionExists("-x"));
+    ASSERT_TRUE(this->mc->optionExists("-y"));
+    ASSERT_TRUE(this->mc->optionExists("-z"));
+    ASSERT_TRUE(this->mc->optionExists("--do_this"));
+}
+
+TEST_F(MiniCommanderTest, testLazyTokenization) {
+    // lazy mode must give the same answers as eager tokenization
+    const int argc = 8;
+    array<const char*, argc> argv_std = {"appname", "-xyz", "--files", "f1", "f2", "--data=/data/dataset", "--do_this", "-a"};
+    char const* const* argv = (char const* const*)argv_std.data();
+    bool unixFlags = true;
+    bool lazy = true;
+    mc = new MiniCommander(argc, argv, unixFlags, lazy);
     auto optionGroups = makeTestOptionGroups();
     for (auto& g : optionGroups)
         mc->addOptionGroup(g);
-    EXPECT_EQ(mc->checkFlags(), true) << "Unix option check failed with argv: " << print(argc, argv);
-    string param = mc->getParameter("--data");
-    ASSERT_STREQ(param.c_str(), "/data/dataset");
+    ASSERT_TRUE(mc->optionExists("-y"));
     vector<string> params = mc->getMultiParameters("--files");
-    ASSERT_STREQ(params[0].c_str(), "f1");
+    ASSERT_EQ(params.size(), 2u) << "failed with argv: " << print(argc, argv);
     ASSERT_STREQ(params[1].c_str(), "f2");
-    ASSERT_TRUE(mc->optionExists("-x"));
-    ASSERT_TRUE(mc->optionExists("-y"));
-    ASSERT_TRUE(mc->optionExists("-z"));
-    ASSERT_TRUE(mc->optionExists("--do_this"));
+    ASSERT_STREQ(mc->getParameter("--data").c_str(), "/data/dataset");
+    EXPECT_EQ(mc->checkFlags(), true) << "failed with argv: " << print(argc, argv);
+    ASSERT_TRUE(mc->optionExists("-a"));
+    ASSERT_FALSE(mc->optionExists("--help"));
+}
+
+TEST_F(MiniCommanderTest, testLazyStopsEarly) {
+    // a query answered by a prefix of argv must not touch the remaining elements,
+    // the null element would crash if it was tokenized
+    const int argc = 4;
+    array<const char*, argc> argv_std = {"appname", "--help", "-d", nullptr};
+    char const* const* argv = (char const* const*)argv_std.data();
+    mc = new MiniCommander(argc, argv, false, true);
+    ASSERT_TRUE(mc->optionExists("--help"));
+    ASSERT_TRUE(mc->optionExists("-d"));
+}
+
+TEST(StaticCommanderTest, testOverflow) {
+    // capacities are exceeded, the overflow is reported and the rest still works
+    const int argc = 3;
+    array<const char*, argc> argv_std = {"appname", "-d=/data/dataset", "-x"};
+    char const* const* argv = (char const* const*)argv_std.data();
+    StaticCommander<3, 2> sc(argc, argv);
+    EXPECT_EQ(sc.status(), Status::ok);
+    StaticCommander<2, 2> small(argc, argv);
+    EXPECT_EQ(small.status(), Status::tooManyTokens);
+    ASSERT_EQ(string(small.getParameter("-d")), "/data/dataset");
+    ASSERT_FALSE(small.optionExists("-x"));
+    StaticOptionGroup<2> group(Policy::required, "required parameters");
+    EXPECT_EQ(group.addOption("-d"), Status::ok);
+    EXPECT_EQ(group.addOption("-x"), Status::ok);
+    EXPECT_EQ(group.addOption("-y"), Status::tooManyOptions);
+    EXPECT_EQ(small.addOptionGroup(group), Status::ok);
+    EXPECT_EQ(small.addOptionGroup(group), Status::tooManyOptions);
+    EXPECT_EQ(small.checkFlags(), false);
+}
+
+TEST(StaticCommanderTest, testSplitView) {
+    // pieces split off at = are views into argv that aren't null-terminated
+    const int argc = 4;
+    array<const char*, argc> argv_std = {"appname", "-f", "a=b", "-g=c"};
+    char const* const* argv = (char const* const*)argv_std.data();
+    StaticCommander<8, 2> sc(argc, argv);
+    StaticOptionGroup<2> group(Policy::optional, "options");
+    group.addOption("-f");
+    group.addOption("-g");
+    sc.addOptionGroup(group);
+    ArgRange params = sc.getMultiParameters("-f");
+    ASSERT_EQ(params.size(), 2u);
+    EXPECT_EQ(params[0].size, 1u);
+    EXPECT_EQ(string(params[0]), "a");
+    EXPECT_EQ(params[0].data[1], '=');
+    EXPECT_EQ(string(params[1]), "b");
+    ArgView option = sc.getParameter("-g");
+    EXPECT_EQ(string(option), "c");
+    EXPECT_TRUE(sc.optionExists("-g"));
+}
+
+TEST_F(MiniCommanderTest, testTryGetParameter) {
+    // test that a missing option is told apart from a missing parameter
+    const int argc = 4;
+    array<const char*, argc> argv_std = {"appname", "-d=/data/dataset", "-f", "-x"};
+    char const* const* argv = (char const* const*)argv_std.data();
+    SetUp(argc, argv);
+    auto optionGroups = makeTestOptionGroups();
+    for (auto& g : optionGroups)
+        mc->addOptionGroup(g);
+    auto param = mc->tryGetParameter("-d");
+    ASSERT_TRUE(param) << "failed with argv: " << print(argc, argv);
+    ASSERT_STREQ(param.value.c_str(), "/data/dataset");
+    EXPECT_EQ(mc->tryGetParameter("-f").status, Status::missingParameter);
+    EXPECT_EQ(mc->tryGetParameter("-a").status, Status::missingOption);
+    EXPECT_FALSE(mc->tryGetParameter("-a"));
+}
+
+#ifdef MINICMD_NO_EXCEPTIONS
+TEST_F(MiniCommanderTest, testNoexcept) {
+    // every operation must be noexcept in the exception-free mode
+    const char* argv[] = {"appname"};
+    OptionGroup group(Policy::optional, "optional parameters");
+    static_assert(noexcept(MiniCommander(1, argv)), "constructor");
+    static_assert(noexcept(OptionGroup(Policy::optional, "")), "OptionGroup constructor");
+    static_assert(noexcept(group.addOption("-a")), "addOption");
+    static_assert(noexcept(mc->addOptionGroup(group)), "addOptionGroup");
+    static_assert(noexcept(mc->checkFlags()), "checkFlags");
+    static_assert(noexcept(mc->printHelpMessage()), "printHelpMessage");
+    static_assert(noexcept(mc->getParameter("-a")), "getParameter");
+    static_assert(noexcept(mc->tryGetParameter("-a")), "tryGetParameter");
+    static_assert(noexcept(mc->getMultiParameters("-a")), "getMultiParameters");
+    static_assert(noexcept(mc->optionExists("-a")), "optionExists");
+    mc = nullptr;
+}
+#endif
+
+TEST_F(MiniCommanderTest, testDefaultValues) {
+    // defaults are used for missing parameters, functions producing them run at most once and only if needed
+    const int argc = 4;
+    array<const char*, argc> argv_std = {"appname", "--data", "/data/dataset", "-j"};
+    char const* const* argv = (char const* const*)argv_std.data();
+    SetUp(argc, argv);
+    int jobsProbes = 0;
+    int dataProbes = 0;
+    int cacheProbes = 0;
+    OptionGroup optionals(Policy::optional, "optional parameters");
+    optionals.addOption("-d", "path to a dataset folder", "--data", [&]() { ++dataProbes; return "/default/data"; });
+    optionals.addOption("-j", "number of jobs", "--jobs", [&]() { ++jobsProbes; return std::to_string(4); });
+    optionals.addOption("-c", "cache directory", "", [&]() { ++cacheProbes; return std::string("/tmp/cache"); });
+    optionals.addOption("-m", "mode", "", "fast");
+    mc->addOptionGroup(optionals);
+    EXPECT_EQ(jobsProbes + dataProbes + cacheProbes, 0);
+    ASSERT_STREQ(mc->getParameter("-d").c_str(), "") << "parameter was given with the alternative flag";
+    ASSERT_STREQ(mc->getParameter("--data").c_str(), "/data/dataset");
+    ASSERT_STREQ(mc->getParameter("-j").c_str(), "4");
+    ASSERT_STREQ(mc->getParameter("--jobs").c_str(), "4");
+    ASSERT_STREQ(mc->tryGetParameter("-j").value.c_str(), "4");
+    ASSERT_STREQ(mc->getParameter("-m").c_str(), "fast");
+    ASSERT_TRUE(mc->getMultiParameters("-j").empty());
+    EXPECT_EQ(jobsProbes, 1);
+    EXPECT_EQ(dataProbes, 0);
+    EXPECT_EQ(cacheProbes, 0);
+    mc->addOptionGroup(OptionGroup(Policy::optional, "more options"));  // compiled again
+    ASSERT_STREQ(mc->getParameter("-j").c_str(), "4");
+    EXPECT_EQ(jobsProbes, 1);
+}
+
+TEST_F(MiniCommanderTest, testConfig) {
+    // config options are merged with argv, which takes precedence
+    const int argc = 4;
+    array<const char*, argc> argv_std = {"appname", "--data", "/data/dataset", "-x"};
+    char const* const* argv = (char const* const*)argv_std.data();
+    SetUp(argc, argv, true);
+    auto optionGroups = makeTestOptionGroups();
+    for (auto& g : optionGroups)
+        mc->addOptionGroup(g);
+    EXPECT_FALSE(mc->checkFlags());
+    const char* config =
+        "# comment\n"
+        "data = /config/data\n"
+        "files = first.txt 'second file.txt'\r\n"
+        "  do_this  \n"
+        "; another comment\n"
+        "[server]\n"
+        "port = 80\n";
+    EXPECT_EQ(mc->loadConfig(config), Status::unknownOption) << "there is no --server.port option";
+    EXPECT_TRUE(mc->checkFlags());
+    ASSERT_STREQ(mc->getParameter("--data").c_str(), "/data/dataset");
+    auto params = mc->getMultiParameters("-f");
+    ASSERT_EQ(params.size(), 2u);
+    ASSERT_STREQ(params[0].c_str(), "first.txt");
+    ASSERT_STREQ(params[1].c_str(), "second file.txt");
+    EXPECT_TRUE(mc->optionExists("--do_this"));
+    EXPECT_TRUE(mc->getMultiParameters("-x").empty());
+}
+
+TEST_F(MiniCommanderTest, testConfigRepeatedKeys) {
+    // the last line of a repeated key wins, also if it names the option by its alternative
+    const int argc = 3;
+    array<const char*, argc> argv_std = {"appname", "--port", "22"};
+    char const* const* argv = (char const* const*)argv_std.data();
+    SetUp(argc, argv);
+    OptionGroup server(Policy::optional, "server options");
+    server.addOption("-p", "port", "--port");
+    server.addOption("-l", "log level", "--level");
+    server.addOption("-H", "hosts", "--hosts");
+    mc->addOptionGroup(server);
+    const char* config =
+        "level = info\n"
+        "hosts = a b\n"
+        "port = 80\n"
+        "l = debug\n"
+        "hosts = c\n"
+        "port = 8080\n";
+    EXPECT_EQ(mc->loadConfig(config), Status::ok);
+    EXPECT_EQ(mc->getParameter("-l"), "debug");
+    EXPECT_EQ(mc->getMultiParameters("-H"), vector<string>({"c"}));
+    EXPECT_FALSE(mc->optionExists("-p"));
+    EXPECT_EQ(mc->getParameter("--port"), "22") << "the command line takes precedence";
+}
+
+TEST_F(MiniCommanderTest, testConfigFile) {
+    // a config file is read at once, sections prefix the keys
+    const char* path = "minicmd_test_config.ini";
+    std::FILE* file = std::fopen(path, "wb");
+    ASSERT_TRUE(file != nullptr);
+    std::fputs("[server]\nport = 8080\n", file);
+    std::fclose(file);
+    const int argc = 1;
+    array<const char*, argc> argv_std = {"appname"};
+    char const* const* argv = (char const* const*)argv_std.data();
+    SetUp(argc, argv);
+    OptionGroup server(Policy::required, "server options");
+    server.addOption("-p", "port", "--server.port");
+    mc->addOptionGroup(server);
+    EXPECT_EQ(mc->loadConfigFile(path), Status::ok);
+    std::remove(path);
+    EXPECT_TRUE(mc->checkFlags());
+    ASSERT_STREQ(mc->getParameter("-p").c_str(), "8080");
+    EXPECT_EQ(mc->loadConfigFile("does/not/exist.ini"), Status::cannotReadFile);
+}
+
+// counts its destructions to check when ReloadableCommander frees snapshots
+struct CountedCommander : MiniCommander {
+    static std::atomic<int> destroyed;
+    CountedCommander(int argc, char const* const* argv) : MiniCommander(argc, argv) {}
+    ~CountedCommander() { ++destroyed; }
+};
+std::atomic<int> CountedCommander::destroyed(0);
+
+TEST(ReloadableCommanderTest, testReload) {
+    // reloads are published atomically, reloads that fail validation are rejected
+    array<const char*, 2> argv_std = {"appname", "-x"};
+    std::string config = "data = /data/first\nfiles = ffirst\n";
+    typedef ReloadableCommander<CountedCommander> Reloadable;
+    std::unique_ptr<Reloadable> reloadable(new Reloadable([&]() {
+        std::unique_ptr<CountedCommander> cmd(new CountedCommander(2, argv_std.data()));
+        OptionGroup required(Policy::required, "required parameters");
+        required.addOption("-d", "path to a dataset folder", "--data");
+        required.addOption("-f", "path to one or multiple files", "--files");
+        cmd->addOptionGroup(required);
+        cmd->loadConfig(config);
+        return cmd;
+    }));
+    std::unique_ptr<Reloadable::Snapshot> first(new Reloadable::Snapshot(reloadable->snapshot()));
+    ASSERT_TRUE(static_cast<bool>(*first));
+    ASSERT_STREQ((*first)->getParameter("-d").c_str(), "/data/first");
+
+    std::atomic<bool> stop(false);
+    std::atomic<int> inconsistent(0);
+    std::thread reader([&]() {
+        while (!stop) {
+            Reloadable::Snapshot snapshot = reloadable->snapshot();
+            std::string data = snapshot->getParameter("-d");
+            std::string file = snapshot->getParameter("-f");
+            if (data.substr(6) != file.substr(1))  // /data/first with ffirst, /data/second with fsecond
+                ++inconsistent;
+        }
+    });
+    for (int i = 0; i < 100; ++i) {
+        config = (i % 2) ? "data = /data/first\nfiles = ffirst\n" : "data = /data/second\nfiles = fsecond\n";
+        EXPECT_TRUE(reloadable->reload());
+    }
+    stop = true;
+    reader.join();
+    EXPECT_EQ(inconsistent, 0);
+
+    config = "data = /data/third\n";
+    EXPECT_FALSE(reloadable->reload()) << "-f is missing";
+    ASSERT_STREQ(reloadable->snapshot()->getParameter("-d").c_str(), "/data/first");
+    ASSERT_STREQ((*first)->getParameter("-d").c_str(), "/data/first") << "pinned snapshots stay valid";
+    int created = 102;  // the initial snapshot, 100 reloads and the rejected one
+    EXPECT_EQ(CountedCommander::destroyed, 1) << "only the rejected snapshot is freed while one is pinned";
+
+    // superseded snapshots are freed by the first reload without readers
+    first.reset();
+    config = "data = /data/second\nfiles = fsecond\n";
+    EXPECT_TRUE(reloadable->reload());
+    ++created;
+    EXPECT_EQ(CountedCommander::destroyed, created - 1);
+    reloadable.reset();
+    EXPECT_EQ(CountedCommander::destroyed, created);
+}
+
+TEST(ReloadableCommanderTest, testLockFreeReaders) {
+    // snapshot() is two atomic operations that don't fall back to a lock, and it isn't blocked by a reload in progress
+    array<const char*, 2> argv_std = {"appname", "-x"};
+    std::atomic<bool> block(false), parsing(false), release(false);
+    ReloadableCommander<> reloadable([&]() {
+        parsing = true;
+        while (block && !release) {}
+        return std::unique_ptr<MiniCommander>(new MiniCommander(2, argv_std.data()));
+    });
+    EXPECT_TRUE(reloadable.isLockFree());
+    block = true;
+    parsing = false;
+    std::thread writer([&]() { reloadable.reload(); });
+    while (!parsing) {}
+    for (int i = 0; i < 1000; ++i)
+        EXPECT_TRUE(reloadable.snapshot()->optionExists("-x"));
+    release = true;
+    writer.join();
+}
+
+TEST_F(MiniCommanderTest, testRegisteredOptions) {
+    // registered options are part of the schema and set their typed globals
+    const int argc = 9;
+    array<const char*, argc> argv_std = {"appname", "--verbose", "--color=false", "--jobs", "0x10",
+                                         "--cache", "/var/cache", "--limit", "many"};
+    char const* const* argv = (char const* const*)argv_std.data();
+    SetUp(argc, argv);
+    mc->addRegisteredOptions();
+    EXPECT_TRUE(mc->checkFlags());
+    EXPECT_EQ(mc->applyRegisteredOptions(), Status::invalidValue) << "--limit many is no number";
+    EXPECT_TRUE(FLAG_verbose);
+    EXPECT_FALSE(FLAG_color);
+    EXPECT_EQ(FLAG_jobs, 16);
+    EXPECT_EQ(FLAG_ratio, 0.5);
+    EXPECT_EQ(FLAG_cache, "/var/cache");
+    EXPECT_EQ(FLAG_limit, 100);
+    size_t registered = 0;
+    for (const RegisteredOption* o = RegisteredOption::first(); o != nullptr; o = o->next)
+        ++registered;
+    EXPECT_EQ(registered, 6u);
+}
+
+void setEnvironmentVariable(const char* name, const char* value) {
+#ifdef _WIN32
+    _putenv_s(name, value);
+#else
+    setenv(name, value, 1);
+#endif
+}
+
+TEST_F(MiniCommanderTest, testEnvironmentVariables) {
+    // missing options fall back to their environment variables, which are read once
+    setEnvironmentVariable("MINICMD_TEST_JOBS", "8");
+    setEnvironmentVariable("MINICMD_TEST_DATA", "/env/data");
+    setEnvironmentVariable("MINICMD_TEST_VERBOSE", "1");
+    const int argc = 3;
+    array<const char*, argc> argv_std = {"appname", "--data", "/data/dataset"};
+    char const* const* argv = (char const* const*)argv_std.data();
+    SetUp(argc, argv);
+    OptionGroup required(Policy::required, "required parameters");
+    required.addOption("-d", "path to a dataset folder", "--data");
+    required.addOption("-j", "number of jobs", "--jobs", "1");
+    required.addOption("-v", "verbose output");
+    required.addEnvironmentVariable("-d", "MINICMD_TEST_DATA");
+    required.addEnvironmentVariable("-j", "MINICMD_TEST_JOBS");
+    required.addEnvironmentVariable("-v", "MINICMD_TEST_VERBOSE");
+    mc->addOptionGroup(required);
+    EXPECT_TRUE(mc->checkFlags());
+    ASSERT_STREQ(mc->getParameter("-d").c_str(), "") << "parameter was given with the alternative flag";
+    ASSERT_STREQ(mc->getParameter("--data").c_str(), "/data/dataset");
+    ASSERT_STREQ(mc->getParameter("--jobs").c_str(), "8") << "environment goes before the default";
+    EXPECT_TRUE(mc->optionExists("-v"));
+    setEnvironmentVariable("MINICMD_TEST_JOBS", "16");
+    ASSERT_STREQ(mc->getParameter("-j").c_str(), "8") << "environment is only read once";
+}
+
+TEST(EnvironmentTest, testBindingByAlternative) {
+    setEnvironmentVariable("MINICMD_TEST_JOBS", "8");
+    MiniCommander cmd("appname -v");
+    OptionGroup options(Policy::optional, "options");
+    options.addOption("-j", "number of jobs", "--jobs");
+    options.addOption("-v", "verbose output");
+    options.addEnvironmentVariable("--jobs", "MINICMD_TEST_JOBS");  // resolves to -j
+    options.addEnvironmentVariable("--undeclared", "MINICMD_TEST_JOBS");  // ignored
+    cmd.addOptionGroup(options);
+    EXPECT_EQ(cmd.getParameter("-j"), "8");
+    EXPECT_EQ(cmd.getParameter("--jobs"), "8");
+    EXPECT_EQ(cmd.getParameter("-v"), "");
+    EXPECT_EQ(cmd.getParameter("--undeclared"), "");
+}
+
+TEST_F(MiniCommanderTest, testSubcommands) {
+    // only the option groups of the invoked subcommand are built
+    const int argc = 5;
+    array<const char*, argc> argv_std = {"appname", "clone", "--depth", "1", "-q"};
+    char const* const* argv = (char const* const*)argv_std.data();
+    SetUp(argc, argv);
+    int builds = 0;
+    mc->addSubcommand("init", [&](MiniCommander&) { ++builds; }, "create a repository");
+    mc->addSubcommand("clone", [&](MiniCommander& cmd) {
+        ++builds;
+        OptionGroup required(Policy::required, "clone options");
+        required.addOption("--depth", "history depth");
+        required.addOption("--url", "repository url");
+        cmd.addOptionGroup(required);
+    }, "clone a repository");
+    mc->addSubcommand("push", [&](MiniCommander&) { ++builds; }, "push changes");
+    EXPECT_EQ(builds, 1);
+    ASSERT_STREQ(mc->subcommand().c_str(), "clone");
+    EXPECT_FALSE(mc->checkFlags()) << "--url is missing in argv: " << print(argc, argv);
+    ASSERT_STREQ(mc->getParameter("--depth").c_str(), "1");
+
+    MiniCommander noSubcommand(2, argv_std.data() + 1);
+    noSubcommand.addSubcommand("clone", [&](MiniCommander&) { ++builds; });
+    EXPECT_EQ(builds, 1);
+    EXPECT_TRUE(noSubcommand.subcommand().empty());
+}
+
+TEST(CommandLineTest, testCommandLine) {
+    // a command line string is split like a POSIX shell would do it
+    MiniCommander cmd("appname -xyz --files 'f 1' f\\ 2 \"f \\\"3\\\"\" --data=/data/dataset  --do_this", true);
+    EXPECT_EQ(cmd.status(), Status::ok);
+    auto optionGroups = makeTestOptionGroups();
+    for (auto& g : optionGroups)
+        cmd.addOptionGroup(g);
+    EXPECT_TRUE(cmd.checkFlags());
+    EXPECT_TRUE(cmd.optionExists("-y"));
+    EXPECT_FALSE(cmd.optionExists("appname"));
+    ASSERT_STREQ(cmd.getParameter("--data").c_str(), "/data/dataset");
+    vector<string> params = cmd.getMultiParameters("--files");
+    ASSERT_EQ(params.size(), 3u);
+    ASSERT_STREQ(params[0].c_str(), "f 1");
+    ASSERT_STREQ(params[1].c_str(), "f 2");
+    ASSERT_STREQ(params[2].c_str(), "f \"3\"");
+}
+
+// std::allocator that counts the allocations of all its rebound copies
+static size_t countedAllocations = 0;
+template<class T>
+struct CountingAllocator : std::allocator<T> {
+    template<class U> struct rebind { typedef CountingAllocator<U> other; };
+    CountingAllocator() {}
+    template<class U> CountingAllocator(const CountingAllocator<U>&) {}
+    T* allocate(size_t n) {
+        ++countedAllocations;
+        return std::allocator<T>::allocate(n);
+    }
+};
+
+TEST(CommandLineTest, testTokensInPlace) {
+    // plain words are tokens in one copy of the line, only quoted or escaped ones are copied
+    string line = "appname --files";
+    for (int i = 0; i < 1000; ++i)
+        line += " /data/some/long/path/file_" + to_string(i) + ".txt";
+    line += " 'a quoted one' an\\ escaped\\ one";
+    countedAllocations = 0;
+    BasicMiniCommander<CountingAllocator<char>> cmd(line);
+    EXPECT_EQ(cmd.status(), Status::ok);
+    EXPECT_LT(countedAllocations, 100u);
+    auto params = cmd.getMultiParameters("--files");
+    ASSERT_EQ(params.size(), 1002u);
+    EXPECT_EQ(params[3], "/data/some/long/path/file_3.txt");
+    EXPECT_EQ(params[1000], "a quoted one");
+    EXPECT_EQ(params[1001], "an escaped one");
+    EXPECT_TRUE(cmd.optionExists("an escaped one"));
+}
+
+TEST(CommandLineTest, testQuotingRules) {
+    // empty quotes, escapes inside double quotes, line continuations and mixed quoting
+    std::vector<std::string> words;
+    std::string scratch;
+    auto split = [&](const char* line) {
+        words.clear();
+        return minicmd::splitCommandLine(ArgView(line), scratch, [&](ArgView w) { words.push_back(w); });
+    };
+    EXPECT_EQ(split("  a ''  \"\" b\t\n"), Status::ok);
+    EXPECT_EQ(words, (std::vector<std::string>{"a", "", "", "b"}));
+    EXPECT_EQ(split("\"\\$x \\a \\\\\" 'it'\\''s' \\\n c"), Status::ok);
+    EXPECT_EQ(words, (std::vector<std::string>{"$x \\a \\", "it's", "c"}));
+    EXPECT_EQ(split("--name=\"a b\"c"), Status::ok);
+    EXPECT_EQ(words, (std::vector<std::string>{"--name=a bc"}));
+    EXPECT_EQ(split("a 'b"), Status::invalidQuoting);
+    EXPECT_EQ(split("a \"b\\"), Status::invalidQuoting);
+    EXPECT_EQ(split("a b\\"), Status::invalidQuoting);
+    MiniCommander cmd("appname -d 'unterminated");
+    EXPECT_EQ(cmd.status(), Status::invalidQuoting);
+    EXPECT_TRUE(cmd.optionExists("-d"));
+}
+
+TEST(ArenaTest, testArenaAllocator) {
+    // all memory of a parse, including the query results, is served by one arena
+    const int argc = 7;
+    array<const char*, argc> argv_std = {"appname", "-xyz", "--files", "f1", "f2", "--data=/data/dataset", "--do_this"};
+    char const* const* argv = (char const* const*)argv_std.data();
+    char buffer[256];
+    MonotonicArena arena(buffer, sizeof(buffer));
+    ArenaAllocator<char> alloc(arena);
+    typedef BasicMiniCommander<ArenaAllocator<char>> ArenaCommander;
+    ArenaCommander cmd(argc, argv, true, false, alloc);
+    BasicOptionGroup<ArenaAllocator<char>> required(Policy::required, "required parameters", alloc);
+    required.addOption("-d", "path to a dataset folder", "--data");
+    required.addOption("-f", "path to one or multiple files", "--files");
+    cmd.addOptionGroup(required);
+    EXPECT_TRUE(cmd.checkFlags());
+    ArenaCommander::String param = cmd.getParameter("--data");
+    ASSERT_STREQ(param.c_str(), "/data/dataset");
+    EXPECT_TRUE(param.get_allocator() == alloc);
+    ArenaCommander::StringVector params = cmd.getMultiParameters("--files");
+    ASSERT_EQ(params.size(), 2u);
+    ASSERT_STREQ(params[1].c_str(), "f2");
+    EXPECT_TRUE(params.get_allocator() == alloc);
+}
+
+#if __cplusplus >= 201703L
+TEST(ArenaTest, testPolymorphicAllocator) {
+    // without a default resource, any memory that doesn't come from the given resource throws std::bad_alloc
+    typedef std::pmr::polymorphic_allocator<char> Allocator;
+    typedef BasicMiniCommander<Allocator> PmrCommander;
+    static char buffer[1 << 16];
+    std::pmr::monotonic_buffer_resource resource(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+    std::pmr::memory_resource* previous = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+    Allocator alloc(&resource);
+    const int argc = 8;
+    array<const char*, argc> argv_std = {"appname", "rest", "-d", "/data/dataset", "--files", "f1", "f2", "--mode=safe"};
+    char const* const* argv = (char const* const*)argv_std.data();
+    PmrCommander cmd(argc, argv, false, false, alloc);
+    BasicOptionGroup<Allocator> required(Policy::required, "required parameters", alloc);
+    required.addOption("-d", "path to a dataset folder", "--data");
+    required.addOption("--files", "path to one or multiple files");
+    required.setArity("--files", Arity::exactly(2));
+    BasicOptionGroup<Allocator> optional(Policy::optional, "optional parameters", alloc);
+    optional.addOption("--mode", "fast or safe", "-m", PmrCommander::DefaultValue(),
+                       PmrCommander::Validator::choices({"fast", "safe"}, alloc));
+    optional.addOption("--ratio", "ratio", "", PmrCommander::DefaultValue([] { return std::string("0.5"); }, alloc),
+                       PmrCommander::Validator::range(0, 1, alloc));
+    cmd.addOptionGroup(required);
+    cmd.addOptionGroup(optional);
+    EXPECT_TRUE(cmd.checkFlags());
+    EXPECT_EQ(cmd.getParameter("-d"), "/data/dataset");
+    EXPECT_EQ(cmd.getMultiParameters("--files").size(), 2u);
+    EXPECT_EQ(cmd.getChoice("--mode").value, 1);
+    PmrCommander::String ratio = cmd.getParameter("--ratio");
+    EXPECT_EQ(ratio, "0.5");
+    EXPECT_TRUE(ratio.get_allocator().resource() == &resource);
+
+    PmrCommander copy = cmd;
+    copy.addOptionGroup(optional);
+    EXPECT_EQ(copy.getParameter("-d"), "/data/dataset");
+    PmrCommander restored = PmrCommander::deserialize(cmd.serialize(), alloc);
+    EXPECT_EQ(restored.getParameter("-d"), "/data/dataset");
+    PmrCommander::ArgvBuilder forwarded = cmd.forwardArguments("child");
+    ASSERT_EQ(forwarded.size(), 2u);
+    EXPECT_STREQ(forwarded.get(1), "rest");
+    std::pmr::set_default_resource(previous);
+}
+#endif
+
+#ifdef __linux__
+// minor page faults of queries in a forked child, i.e. copy-on-write faults, -1 if the child failed
+template<class Commander>
+long childPageFaults(const Commander& cmd) {
+    int fds[2];
+    if (pipe(fds) != 0)
+        return -1;
+    pid_t pid = fork();
+    if (pid == 0) {
+        rusage before, after;
+        getrusage(RUSAGE_SELF, &before);
+        size_t results = 0;
+        for (int i = 0; i < 100; ++i)
+            results += cmd.checkFlags() + cmd.getParameter("-d").size() + cmd.optionExists("/data/file_4999.txt");
+        getrusage(RUSAGE_SELF, &after);
+        long faults = (results > 0) ? after.ru_minflt - before.ru_minflt : -1;
+        _exit(write(fds[1], &faults, sizeof(faults)) == sizeof(faults) ? 0 : 1);
+    }
+    long faults = -1;
+    if (pid > 0 && read(fds[0], &faults, sizeof(faults)) != sizeof(faults))
+        faults = -1;
+    int status = 1;
+    waitpid(pid, &status, 0);
+    close(fds[0]);
+    close(fds[1]);
+    return status == 0 ? faults : -1;
+}
+
+TEST(ArenaTest, testSealableArena) {
+    string commandLine = "appname -d /data/dataset --files";
+    for (int i = 0; i < 5000; ++i)
+        commandLine += " /data/file_" + to_string(i) + ".txt";
+
+    // the whole parser including the object itself in one mapping, read-only before forking
+    typedef BasicMiniCommander<ArenaAllocator<char>> ArenaCommander;
+    SealableArena arena(16 << 20);
+    ArenaAllocator<char> alloc(arena);
+    ArenaCommander* cmd = new (arena.allocate(sizeof(ArenaCommander), alignof(ArenaCommander)))
+        ArenaCommander(commandLine, true, alloc);
+    {
+        BasicOptionGroup<ArenaAllocator<char>> required(Policy::required, "required parameters", alloc);
+        required.addOption("-d", "path to a dataset folder", "--data");
+        required.addOption("-f", "path to one or multiple files", "--files");
+        cmd->addOptionGroup(required);
+    }
+    cmd->freeze();
+    ASSERT_TRUE(arena.seal());
+    EXPECT_TRUE(arena.isSealed());
+
+    // queries work while sealed, their results come from the heap
+    EXPECT_TRUE(cmd->checkFlags());
+    ArenaCommander::String param = cmd->getParameter("-d");
+    EXPECT_STREQ(param.c_str(), "/data/dataset");
+    EXPECT_FALSE(arena.contains(param.data()));
+    EXPECT_EQ(cmd->getMultiParameters("--files").size(), 5000u);
+
+    // children query the parser without writing to it, a write would crash them,
+    // so none of its more than 100 pages is copied
+    long faults = childPageFaults(*cmd);
+    ASSERT_GE(faults, 0);
+    EXPECT_LT(faults, 16);
+
+    ASSERT_TRUE(arena.unseal());
+    cmd->~ArenaCommander();
+}
+#endif
+
+#ifdef __linux__
+// writes a /proc-like directory with a cmdline file per pid
+void writeProcessDirectory(const string& root, const vector<pair<long, string>>& processes) {
+    mkdir(root.c_str(), 0755);
+    for (auto& process : processes) {
+        string dir = root + "/" + to_string(process.first);
+        mkdir(dir.c_str(), 0755);
+        ofstream(dir + "/cmdline", ios::binary) << process.second;
+    }
+}
+
+void removeProcessDirectory(const string& root, const vector<pair<long, string>>& processes) {
+    for (auto& process : processes) {
+        string dir = root + "/" + to_string(process.first);
+        std::remove((dir + "/cmdline").c_str());
+        rmdir(dir.c_str());
+    }
+    rmdir(root.c_str());
+}
+
+TEST(ProcessTest, testFromProcess) {
+    MiniCommander self = MiniCommander::fromProcess();
+    EXPECT_EQ(self.status(), Status::ok);
+    MiniCommander missing = MiniCommander::fromProcess(-1);
+    EXPECT_EQ(missing.status(), Status::cannotReadFile);
+
+    string root = "minicmd_proc";
+    vector<pair<long, string>> processes = {{42, string("app\0-d\0/data\0--files\0a b\0c\0", 27)}};
+    writeProcessDirectory(root, processes);
+    MiniCommander cmd = MiniCommander::fromCmdlineFile(root + "/42/cmdline", true);
+    removeProcessDirectory(root, processes);
+    EXPECT_EQ(cmd.status(), Status::ok);
+    EXPECT_EQ(cmd.getParameter("-d"), "/data");
+    EXPECT_EQ(cmd.getMultiParameters("--files"), vector<string>({"a b", "c"}));
+    EXPECT_FALSE(cmd.optionExists("app"));
+}
+
+TEST(ProcessTest, testScanProcesses) {
+    string root = "minicmd_proc_scan";
+    vector<pair<long, string>> processes;
+    for (long pid = 1; pid <= 50; ++pid)
+        processes.push_back({pid, "app" + string(1, '\0') + (pid % 2 ? "-x" : "-y") + string(1, '\0')});
+    writeProcessDirectory(root, processes);
+    mkdir((root + "/self").c_str(), 0755);  // not a pid
+
+    OptionGroup formats(Policy::anyOf, "formats");
+    formats.addOption("-x", "use x format");
+    formats.addOption("-y", "use y format");
+    vector<OptionGroup> schema = {formats};
+    for (unsigned threads : {1u, 4u}) {
+        auto results = MiniCommander::scanProcesses(schema, [](const MiniCommander& cmd) {
+            return cmd.optionExists("-x") && cmd.checkFlags();
+        }, root, threads);
+        ASSERT_EQ(results.size(), 50u);
+        for (size_t i = 0; i < results.size(); ++i) {
+            EXPECT_EQ(results[i].first, long(i + 1));
+            EXPECT_EQ(results[i].second, results[i].first % 2 == 1);
+        }
+    }
+    rmdir((root + "/self").c_str());
+    removeProcessDirectory(root, processes);
+}
+#endif
+
+TEST(ProcessTest, testSharedOptionGroups) {
+    // copies share the compiled option groups, adding a group copies them first
+    OptionGroup formats(Policy::anyOf, "formats");
+    formats.addOption("-x", "use x format");
+    OptionGroup extra(Policy::required, "extra");
+    extra.addOption("-z", "required option");
+    MiniCommander cmd("app -x", true);
+    cmd.addOptionGroup(formats);
+    EXPECT_TRUE(cmd.checkFlags());
+    MiniCommander copy = cmd;
+    EXPECT_TRUE(copy.checkFlags());
+    copy.addOptionGroup(extra);
+    EXPECT_FALSE(copy.checkFlags());
+    EXPECT_TRUE(cmd.checkFlags()) << "the original keeps its option groups";
+    EXPECT_TRUE(cmd.optionExists("-x"));
+}
+
+TEST(CanonicalTest, testCanonicalArguments) {
+    // semantically identical invocations have the same canonical form and hash
+    auto optionGroups = makeTestOptionGroups();
+    auto parse = [&](const char* commandLine) {
+        MiniCommander cmd(commandLine, true);
+        for (auto& g : optionGroups)
+            cmd.addOptionGroup(g);
+        return cmd;
+    };
+    MiniCommander cmd = parse("appname build -xz --data=/data/dataset --files a b --do_this");
+    vector<string> canonical = {"build", "--do_this", "-d", "/data/dataset", "-f", "a", "b", "-x", "-z"};
+    EXPECT_EQ(cmd.canonicalArguments(), canonical);
+    for (const char* same : {"appname build -d /data/dataset -z --do_this -x -f a b",
+                             "appname build --files a b -zx --do_this --data /data/dataset"}) {
+        EXPECT_EQ(parse(same).canonicalArguments(), canonical);
+        EXPECT_EQ(parse(same).canonicalHash(), cmd.canonicalHash());
+    }
+    // the canonical form parses to itself
+    string canonicalLine = "appname";
+    for (auto& arg : canonical)
+        canonicalLine += " " + arg;
+    EXPECT_EQ(parse(canonicalLine.c_str()).canonicalHash(), cmd.canonicalHash());
+
+    // order of multi parameters and positional arguments, values and flags matter
+    for (const char* different : {"appname build -xz --data=/data/dataset --files b a --do_this",
+                                  "appname test -xz --data=/data/dataset --files a b --do_this",
+                                  "appname build -xz --data=/data/other --files a b --do_this",
+                                  "appname build -x --data=/data/dataset --files a b --do_this",
+                                  "appname build -xz --data=/data/dataset --files a --do_this b"}) {
+        EXPECT_NE(parse(different).canonicalArguments(), canonical) << different;
+        EXPECT_NE(parse(different).canonicalHash(), cmd.canonicalHash()) << different;
+    }
+}
+
+TEST(CanonicalTest, testNoCollisions) {
+    // repeated options and unknown options are part of the canonical form
+    OptionGroup options(Policy::optional, "options");
+    options.addOption("-I*", "include directory");
+    options.addOption("-I", "include directory");
+    options.addOption("--verbose", "verbose output", "-v");
+    options.setArity("--verbose", Arity::none());
+    auto parse = [&](const char* commandLine) {
+        MiniCommander cmd(commandLine, true);
+        cmd.addOptionGroup(options);
+        return cmd;
+    };
+    const vector<pair<const char*, const char*>> different = {
+        {"app -I a -I b --unknown", "app -I a -I c"},
+        {"app -I a -I b", "app -I a b"},
+        {"app --verbose --typo", "app --verbose"},
+        {"app -v -q", "app -v"},
+        {"app --typo x", "app --typo"}};
+    for (auto& d : different) {
+        EXPECT_NE(parse(d.first).canonicalArguments(), parse(d.second).canonicalArguments()) << d.first;
+        EXPECT_NE(parse(d.first).canonicalHash(), parse(d.second).canonicalHash()) << d.first;
+    }
+    EXPECT_EQ(parse("app -I b --typo x -v -I a").canonicalArguments(),
+              vector<string>({"--verbose", "-I", "b", "-I", "a", "--typo", "x"}));
+    EXPECT_EQ(parse("app -I b --typo x -v -I a").canonicalHash(), parse("app -v -I b --typo x -I a").canonicalHash());
+}
+
+TEST(SerializationTest, testRoundTrip) {
+    auto optionGroups = makeTestOptionGroups();
+    MiniCommander cmd("appname -xyz --files 'f 1' f2 -d /data --do_this -d /other", true);
+    string data = cmd.serialize();
+    MiniCommander restored = MiniCommander::deserialize(data);
+    EXPECT_EQ(restored.status(), Status::ok);
+    for (auto& g : optionGroups) {
+        cmd.addOptionGroup(g);
+        restored.addOptionGroup(g);
+    }
+    EXPECT_TRUE(restored.checkFlags());
+    EXPECT_EQ(restored.getParameter("-d"), "/data");
+    EXPECT_EQ(restored.getMultiParameters("--files"), vector<string>({"f 1", "f2"}));
+    EXPECT_EQ(restored.canonicalArguments(), cmd.canonicalArguments());
+    EXPECT_EQ(restored.canonicalHash(), cmd.canonicalHash());
+    EXPECT_EQ(restored.serialize(), data);
+
+    // no tokens
+    MiniCommander empty("appname");
+    EXPECT_EQ(MiniCommander::deserialize(empty.serialize()).status(), Status::ok);
+
+    // truncated or corrupted data
+    EXPECT_EQ(MiniCommander::deserialize("").status(), Status::invalidFormat);
+    EXPECT_EQ(MiniCommander::deserialize(data.substr(0, data.size() - 1)).status(), Status::invalidFormat);
+    EXPECT_EQ(MiniCommander::deserialize(data.substr(0, 28)).status(), Status::invalidFormat);
+    string badMagic = data;
+    badMagic[0] = 'X';
+    EXPECT_EQ(MiniCommander::deserialize(badMagic).status(), Status::invalidFormat);
+    string badVersion = data;
+    badVersion[4] = 9;
+    EXPECT_EQ(MiniCommander::deserialize(badVersion).status(), Status::invalidFormat);
+    string badOffset = data;
+    badOffset[24] = 100;  // end of the first token
+    MiniCommander corrupted = MiniCommander::deserialize(badOffset);
+    EXPECT_EQ(corrupted.status(), Status::invalidFormat);
+    EXPECT_FALSE(corrupted.optionExists("-x"));
+}
+
+TEST(SerializationTest, testView) {
+    // the tokens and the sorted index are used in the blob, the subcommand is restored
+    MiniCommander git("git commit --amend -m msg");
+    int built = 0;
+    auto commitOptions = [&](MiniCommander& cmd) {
+        OptionGroup commit(Policy::optional, "commit options");
+        commit.addOption("-m", "message");
+        commit.addOption("--amend", "amend the last commit");
+        commit.addOption("--author", "author");
+        cmd.addOptionGroup(commit);
+        ++built;
+    };
+    git.addSubcommand("commit", commitOptions);
+    string data = git.serialize();
+    MiniCommander view = MiniCommander::deserializeView(data);
+    EXPECT_EQ(view.status(), Status::ok);
+    EXPECT_EQ(view.subcommand(), "commit");
+    EXPECT_TRUE(minicmd::isWithin(view.positional(0), data));
+    view.addSubcommand("commit", commitOptions);
+    view.addSubcommand("commit", commitOptions);
+    EXPECT_EQ(built, 2);
+    EXPECT_TRUE(view.optionExists("--amend"));
+    EXPECT_FALSE(view.optionExists("--amen"));
+    EXPECT_EQ(view.getParameter("-m"), "msg");
+    EXPECT_EQ(view.serialize(), data);
+
+    // tokens added later are indexed together with the restored ones
+    EXPECT_EQ(view.loadConfig("author = me"), Status::ok);
+    EXPECT_EQ(view.getParameter("--author"), "me");
+    EXPECT_TRUE(view.optionExists("--amend"));
+    EXPECT_EQ(view.getParameter("-m"), "msg");
+
+    // the index has to be sorted
+    string unsorted = data;
+    size_t numTokens = minicmd::readUint32(&data[20]);
+    std::swap_ranges(&unsorted[28 + 4 * numTokens], &unsorted[32 + 4 * numTokens], &unsorted[32 + 4 * numTokens]);
+    EXPECT_EQ(MiniCommander::deserializeView(unsorted).status(), Status::invalidFormat);
+}
+
+#ifdef __linux__
+TEST(SerializationTest, testPipe) {
+    // parse in the parent, use it in the child without parsing again
+    MiniCommander cmd("appname -d /data/dataset --files a b", true);
+    string data = cmd.serialize();
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        close(fds[0]);
+        ssize_t written = write(fds[1], data.data(), data.size());
+        _exit(written == ssize_t(data.size()) ? 0 : 1);
+    }
+    close(fds[1]);
+    string received;
+    char buffer[256];
+    for (ssize_t n; (n = read(fds[0], buffer, sizeof(buffer))) > 0; )
+        received.append(buffer, n);
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    EXPECT_EQ(status, 0);
+
+    MiniCommander restored = MiniCommander::deserialize(received);
+    EXPECT_EQ(restored.status(), Status::ok);
+    OptionGroup required(Policy::required, "required parameters");
+    required.addOption("-d", "path to a dataset folder", "--data");
+    required.addOption("-f", "path to one or multiple files", "--files");
+    restored.addOptionGroup(required);
+    EXPECT_TRUE(restored.checkFlags());
+    EXPECT_EQ(restored.getParameter("-d"), "/data/dataset");
+    EXPECT_EQ(restored.getMultiParameters("--files"), vector<string>({"a", "b"}));
+}
+#endif
+
+TEST(ArgvBuilderTest, testForwardArguments) {
+    // the wrapper consumes its own options and passes on the rest
+    const int argc = 9;
+    array<const char*, argc> argv_std = {"wrapper", "input.txt", "-d", "/data", "--unknown", "x", "-xz", "--level=3", "--data=/other"};
+    char const* const* argv = (char const* const*)argv_std.data();
+    MiniCommander cmd(argc, argv, true, true);  // lazy, argv outlives cmd
+    OptionGroup own(Policy::optional, "wrapper options");
+    own.addOption("-d", "path to a dataset folder", "--data");
+    own.addOption("-x", "use x format");
+    cmd.addOptionGroup(own);
+    ArgvBuilder args = cmd.forwardArguments("child");
+    vector<string> forwarded;
+    for (size_t i = 0; i < args.size(); ++i)
+        forwarded.push_back(args.get(i));
+    EXPECT_EQ(forwarded, vector<string>({"child", "input.txt", "--unknown", "x", "-z", "--level", "3"}));
+    // whole argv elements aren't copied
+    EXPECT_EQ(args.get(1), argv[1]);
+    EXPECT_EQ(args.get(2), argv[4]);
+    EXPECT_EQ(args.get(3), argv[5]);
+    EXPECT_NE(args.get(4), argv[6]);
+
+    args.remove("--unknown", 1).rewrite("-z", "--zip").add("--threads=4");
+    char* const* childArgv = args.argv();
+    vector<string> exec;
+    for (char* const* arg = childArgv; *arg != nullptr; ++arg)
+        exec.push_back(*arg);
+    EXPECT_EQ(exec, vector<string>({"child", "input.txt", "--zip", "--level", "3", "--threads=4"}));
+    EXPECT_EQ(childArgv[1], argv[1]);
+    EXPECT_EQ(args.size(), 6u);
+}
+
+TEST(ArgvBuilderTest, testEagerCopies) {
+    // an eager MiniCommander doesn't point into argv, which may be gone when arguments are forwarded
+    auto parse = []() {
+        vector<string> arguments = {"wrapper", "input.txt", "-d", "/data", "--unknown"};
+        vector<const char*> argv;
+        for (auto& argument : arguments)
+            argv.push_back(argument.c_str());
+        MiniCommander cmd(static_cast<int>(argv.size()), argv.data(), true);
+        OptionGroup own(Policy::optional, "wrapper options");
+        own.addOption("-d", "path to a dataset folder");
+        cmd.addOptionGroup(own);
+        return cmd;
+    };
+    MiniCommander cmd = parse();
+    ArgvBuilder args = cmd.forwardArguments("child");
+    vector<string> forwarded;
+    for (size_t i = 0; i < args.size(); ++i)
+        forwarded.push_back(args.get(i));
+    EXPECT_EQ(forwarded, vector<string>({"child", "input.txt", "--unknown"}));
+}
+
+TEST(PrefixFamilyTest, testPrefixFamilies) {
+    // compiler-driver style options with joined values
+    MiniCommander cmd("cc -O2 -I/usr/include -I /opt/include -Wall -Wno-unused -Wno-sign-compare -fno-exceptions -c main.c -o main.o");
+    OptionGroup compiler(Policy::required, "compiler options");
+    compiler.addOption("-c", "compile only");
+    compiler.addOption("-o", "output file");
+    compiler.addOption("-O*", "optimization level");
+    compiler.addOption("-I*", "include directory");
+    OptionGroup warnings(Policy::optional, "warnings");
+    warnings.addOption("-Wall", "all warnings");
+    warnings.addOption("-W*", "enable a warning");
+    warnings.addOption("-Wno-*", "disable a warning");
+    warnings.addOption("-f*", "code generation option");
+    warnings.addOption("-L*", "library directory");
+    cmd.addOptionGroup(compiler);
+    cmd.addOptionGroup(warnings);
+
+    EXPECT_TRUE(cmd.checkFlags());
+    EXPECT_TRUE(cmd.optionExists("-O*"));
+    EXPECT_FALSE(cmd.optionExists("-L*"));
+    EXPECT_EQ(cmd.getParameter("-O*"), "2");
+    EXPECT_EQ(cmd.getMultiParameters("-I*"), vector<string>({"/usr/include", "/opt/include"}));
+    // the exact flag and the longest prefix win
+    EXPECT_TRUE(cmd.optionExists("-Wall"));
+    EXPECT_EQ(cmd.getMultiParameters("-Wno-*"), vector<string>({"unused", "sign-compare"}));
+    EXPECT_TRUE(cmd.getMultiParameters("-W*").empty());
+    EXPECT_FALSE(cmd.optionExists("-W*"));
+    EXPECT_EQ(cmd.getMultiParameters("-f*"), vector<string>({"no-exceptions"}));
+    // family members end the parameters of the previous option
+    EXPECT_EQ(cmd.getMultiParameters("-c"), vector<string>({"main.c"}));
+    EXPECT_EQ(cmd.getParameter("-o"), "main.o");
+    EXPECT_EQ(cmd.tryGetParameter("-L*").status, Status::missingOption);
+
+    // order of the members is kept in the canonical form
+    auto canonical = cmd.canonicalArguments();
+    EXPECT_EQ(canonical, vector<string>({"-I/usr/include", "-I", "/opt/include", "-O2", "-Wall", "-Wno-unused",
+                                         "-Wno-sign-compare", "-c", "main.c", "-fno-exceptions", "-o", "main.o"}));
+    MiniCommander reordered("cc -c main.c -Wno-unused -I/usr/include -O2 -o main.o -Wall -fno-exceptions -Wno-sign-compare -I /opt/include");
+    reordered.addOptionGroup(compiler);
+    reordered.addOptionGroup(warnings);
+    EXPECT_EQ(reordered.canonicalHash(), cmd.canonicalHash());
+
+    // a member with a joined value takes no further arguments, a bare one takes the next
+    MiniCommander joined("c++ -I/usr/include main.cpp -o main.o -I /opt/include other.cpp");
+    OptionGroup driver(Policy::optional, "driver options");
+    driver.addOption("-I*", "include directory");
+    driver.addOption("-o", "output file");
+    joined.addOptionGroup(driver);
+    ASSERT_EQ(joined.numPositionals(), 1u);
+    EXPECT_EQ(joined.positional(0), "main.cpp");
+    EXPECT_EQ(joined.getMultiParameters("-I*"), vector<string>({"/usr/include", "/opt/include"}));
+    EXPECT_EQ(joined.getMultiParameters("-o"), vector<string>({"main.o"}));
+    ArgvBuilder forwarded = joined.forwardArguments();
+    ASSERT_EQ(forwarded.size(), 1u);
+    EXPECT_STREQ(forwarded.get(0), "main.cpp");
+    MiniCommander swapped("cc -c main.c -Wno-unused -I /opt/include -O2 -o main.o -Wall -fno-exceptions -Wno-sign-compare -I/usr/include");
+    swapped.addOptionGroup(compiler);
+    swapped.addOptionGroup(warnings);
+    EXPECT_NE(swapped.canonicalHash(), cmd.canonicalHash());
+}
+
+TEST(AbbreviationTest, testAbbreviations) {
+    OptionGroup options(Policy::optional, "options");
+    options.addOption("--verbose", "verbose output");
+    options.addOption("--version", "print the version");
+    options.addOption("-d", "path to a dataset folder", "--data");
+    options.addOption("--dry-run", "don't do anything");
+    options.addOption("--files", "input files");
+
+    // off by default
+    MiniCommander exact("app --verb --dat /data --fi a b");
+    exact.addOptionGroup(options);
+    EXPECT_FALSE(exact.optionExists("--verbose"));
+
+    MiniCommander cmd("app --verb --dat /data --fi a b");
+    cmd.addOptionGroup(options);
+    cmd.setAbbreviations(true);
+    EXPECT_EQ(cmd.status(), Status::ok);
+    EXPECT_TRUE(cmd.optionExists("--verbose"));
+    EXPECT_FALSE(cmd.optionExists("--verb"));
+    EXPECT_EQ(cmd.getParameter("--data"), "/data");
+    EXPECT_EQ(cmd.getMultiParameters("--files"), vector<string>({"a", "b"}));
+    EXPECT_EQ(cmd.canonicalArguments(), vector<string>({"--files", "a", "b", "--verbose", "-d", "/data"}));
+
+    // exact names and short flags aren't touched, --ver and --d are ambiguous
+    MiniCommander ambiguous("app --ver --version --d -d");
+    ambiguous.setAbbreviations(true);
+    ambiguous.addOptionGroup(options);
+    EXPECT_EQ(ambiguous.status(), Status::ambiguousOption);
+    EXPECT_TRUE(ambiguous.optionExists("--version"));
+    EXPECT_FALSE(ambiguous.optionExists("--verbose"));
+    EXPECT_TRUE(ambiguous.optionExists("-d"));
+
+    // abbreviations in lazily tokenized arguments after the options are compiled
+    const int argc = 4;
+    array<const char*, argc> argv_std = {"app", "--dr", "--vers", "--fil"};
+    char const* const* argv = (char const* const*)argv_std.data();
+    MiniCommander lazy(argc, argv, false, true);
+    lazy.setAbbreviations(true);
+    lazy.addOptionGroup(options);
+    EXPECT_TRUE(lazy.optionExists("--dry-run"));
+    EXPECT_TRUE(lazy.optionExists("--version"));
+    EXPECT_TRUE(lazy.optionExists("--files"));
+    EXPECT_EQ(lazy.status(), Status::ok);
+}
+
+TEST(SuggestionTest, testEditDistance) {
+    // the bit-parallel kernel agrees with the dynamic program
+    EXPECT_EQ(minicmd::EditDistance("--verbose")("--verbose"), 0u);
+    EXPECT_EQ(minicmd::EditDistance("--verbos")("--verbose"), 1u);
+    EXPECT_EQ(minicmd::EditDistance("--vrebose")("--verbose"), 2u);
+    EXPECT_EQ(minicmd::EditDistance("kitten")("sitting"), 3u);
+    EXPECT_EQ(minicmd::EditDistance("-x")(""), 2u);
+    string longPattern(100, 'a');
+    EXPECT_EQ(minicmd::EditDistance(longPattern)(string(98, 'a') + "bb"), 2u);
+    srand(42);
+    for (int i = 0; i < 1000; ++i) {
+        string a, b;
+        for (int n = rand() % 20; n > 0; --n)
+            a += char('a' + rand() % 4);
+        for (int n = rand() % 20; n > 0; --n)
+            b += char('a' + rand() % 4);
+        // with a padded pattern of more than 64 characters, the dynamic program is used
+        string padding(70, 'z');
+        EXPECT_EQ(minicmd::EditDistance(a)(b), minicmd::EditDistance(padding + a)(padding + b)) << a << " " << b;
+    }
+}
+
+TEST(SuggestionTest, testUnknownOptions) {
+    MiniCommander cmd("app --verbos -d /data --dtaa -5 --files a -I/usr/include --qwertyuiop --verbos");
+    OptionGroup options(Policy::optional, "options");
+    options.addOption("--verbose", "verbose output");
+    options.addOption("--version", "print the version");
+    options.addOption("-d", "path to a dataset folder", "--data");
+    options.addOption("--files", "input files");
+    options.addOption("-I*", "include directory");
+    cmd.addOptionGroup(options);
+
+    EXPECT_EQ(cmd.unknownOptions(), vector<string>({"--verbos", "--dtaa", "--qwertyuiop"}));
+    EXPECT_EQ(cmd.suggestOptions("--verbos"), vector<string>({"--verbose"}));
+    EXPECT_EQ(cmd.suggestOptions("--verbosion"), vector<string>({"--version", "--verbose"}));
+    EXPECT_EQ(cmd.suggestOptions("--verbosion", 1), vector<string>({"--version"}));
+    EXPECT_EQ(cmd.suggestOptions("--dtaa"), vector<string>({"--data"}));
+    EXPECT_TRUE(cmd.suggestOptions("--qwertyuiop").empty());
+    EXPECT_FALSE(cmd.checkUnknownOptions());
+
+    MiniCommander known("app --verbose -d /data");
+    known.addOptionGroup(options);
+    EXPECT_TRUE(known.unknownOptions().empty());
+    EXPECT_TRUE(known.checkUnknownOptions());
+}
+
+TEST(StrictTest, testStrictMode) {
+    auto optionGroups = makeTestOptionGroups();
+    auto parse = [&](const char* commandLine, bool allowPositionals) {
+        MiniCommander cmd(commandLine);
+        cmd.setStrict(true, allowPositionals);
+        for (auto& g : optionGroups)
+            cmd.addOptionGroup(g);
+        return cmd;
+    };
+    MiniCommander cmd = parse("app input.txt -d /data --files a b --do_this --typo -x", true);
+    EXPECT_EQ(cmd.tokenKinds(), (minicmd::Vector<std::allocator<char>, TokenKind>{
+        TokenKind::positional, TokenKind::flag, TokenKind::parameter, TokenKind::flag, TokenKind::parameter,
+        TokenKind::parameter, TokenKind::flag, TokenKind::unknown, TokenKind::flag}));
+    EXPECT_EQ(cmd.status(), Status::unknownOption);
+    // the queries agree with the classification
+    EXPECT_EQ(cmd.getMultiParameters("--files"), vector<string>({"a", "b"}));
+    EXPECT_EQ(cmd.unknownOptions(), vector<string>({"--typo"}));
+
+    EXPECT_EQ(parse("app input.txt -d /data --files a --do_this -x", true).status(), Status::ok);
+    EXPECT_EQ(parse("app input.txt -d /data --files a --do_this -x", false).status(), Status::unexpectedArgument);
+    EXPECT_EQ(parse("app -d /data --files a --do_this -x", false).status(), Status::ok);
+
+    // the invoked subcommand isn't a stray argument
+    MiniCommander subcommand("app clone --url x");
+    subcommand.setStrict(true);
+    subcommand.addSubcommand("clone", [](MiniCommander& cmd) {
+        OptionGroup cloneOptions(Policy::required, "clone options");
+        cloneOptions.addOption("--url", "repository to clone");
+        cmd.addOptionGroup(cloneOptions);
+    });
+    EXPECT_EQ(subcommand.status(), Status::ok);
+
+    // without strict mode, unknown options are accepted
+    MiniCommander lenient("app -d /data --typo");
+    for (auto& g : optionGroups)
+        lenient.addOptionGroup(g);
+    EXPECT_EQ(lenient.status(), Status::ok);
+}
+
+TEST(ArityTest, testArity) {
+    OptionGroup options(Policy::optional, "options");
+    options.addOption("--verbose", "verbose output");
+    options.addOption("--range", "lower and upper bound");
+    options.addOption("--offset", "offset, may be negative");
+    options.addOption("--files", "input files");
+    options.addOption("--jobs", "number of jobs, optional");
+    options.addOption("--exec", "command to run");
+    options.setArity("--verbose", Arity::none());
+    options.setArity("--range", Arity::exactly(2));
+    options.setArity("--offset", Arity::exactly(1));
+    options.setArity("--files", Arity::range(1, 3));
+    options.setArity("--jobs", Arity::range(0, 1));
+    options.setArity("--exec", Arity::untilNextFlag());
+    auto parse = [&](const char* commandLine) {
+        MiniCommander cmd(commandLine, true);
+        cmd.addOptionGroup(options);
+        return cmd;
+    };
+
+    // values that look like flags are parameters, tokens after them are positional
+    MiniCommander cmd = parse("app --range -5 5 in.txt --offset -3 --verbose out.txt --files a b c d --exec ls -l --jobs");
+    EXPECT_EQ(cmd.status(), Status::ok);
+    EXPECT_EQ(cmd.getMultiParameters("--range"), vector<string>({"-5", "5"}));
+    EXPECT_EQ(cmd.getParameter("--offset"), "-3");
+    EXPECT_EQ(cmd.getParameter("--verbose"), "");
+    EXPECT_EQ(cmd.getMultiParameters("--files"), vector<string>({"a", "b", "c"}));
+    EXPECT_EQ(cmd.getMultiParameters("--exec"), vector<string>({"ls", "-l"}));
+    EXPECT_TRUE(cmd.getMultiParameters("--jobs").empty());
+    EXPECT_TRUE(cmd.optionExists("--jobs"));
+    ASSERT_EQ(cmd.numPositionals(), 3u);
+    EXPECT_EQ(cmd.positional(0), "in.txt");
+    EXPECT_EQ(cmd.positional(1), "out.txt");
+    EXPECT_EQ(cmd.positional(2), "d");
+    EXPECT_TRUE(cmd.unknownOptions().empty());
+
+    // same in lazy mode, where the parameters are assigned as argv is tokenized
+    const int argc = 6;
+    array<const char*, argc> argv_std = {"app", "--files", "x", "-y", "--offset", "-1"};
+    MiniCommander lazy(argc, (char const* const*)argv_std.data(), true, true);
+    lazy.addOptionGroup(options);
+    EXPECT_EQ(lazy.getMultiParameters("--files"), vector<string>({"x", "-y"}));
+    EXPECT_EQ(lazy.getParameter("--offset"), "-1");
+
+    // fewer parameters than the minimum
+    EXPECT_EQ(parse("app --range 1").status(), Status::missingParameter);
+    EXPECT_EQ(parse("app --range 1 --verbose").status(), Status::missingParameter);
+    EXPECT_EQ(parse("app --files").status(), Status::missingParameter);
+    EXPECT_EQ(parse("app --files a --jobs").status(), Status::ok);
+
+    // the canonical form and forwarding follow the assigned parameters
+    MiniCommander reordered = parse("app --verbose out.txt --range -5 5");
+    EXPECT_EQ(reordered.canonicalArguments(), vector<string>({"out.txt", "--range", "-5", "5", "--verbose"}));
+    EXPECT_EQ(parse("app --range -5 5 --verbose out.txt").canonicalHash(), reordered.canonicalHash());
+    EXPECT_EQ(reordered.forwardArguments().size(), 1u);
+}
+
+TEST(ValidatorTest, testValidators) {
+    OptionGroup options(Policy::optional, "options");
+    options.addOption("--mode", "fast or safe", "-m", DefaultValue(), Validator::choices({"fast", "safe", "paranoid"}));
+    options.addOption("--ratio", "ratio", "", DefaultValue(), Validator::range(0, 1));
+    options.addOption("--even", "even number", "", DefaultValue(),
+                      Validator([](ArgView value) { return std::atoi(std::string(value).c_str()) % 2 == 0; }, "an even number"));
+    OptionGroup required(Policy::required, "required");
+    required.addOption("--out", "output file");
+    auto parse = [&](const char* commandLine) {
+        MiniCommander cmd(commandLine);
+        cmd.addOptionGroup(options);
+        cmd.addOptionGroup(required);
+        return cmd;
+    };
+
+    MiniCommander valid = parse("app --out o -m safe --ratio 0.25 --even 4");
+    EXPECT_TRUE(valid.validationErrors().empty());
+    EXPECT_TRUE(valid.checkFlags());
+    EXPECT_EQ(valid.getChoice("-m").value, 1);
+    EXPECT_EQ(valid.getChoice("-m").status, Status::ok);
+    EXPECT_EQ(parse("app --mode paranoid").getChoice("--mode").value, 2);
+
+    // all failures are reported together
+    MiniCommander invalid = parse("app --mode turbo --ratio 1.5 --even 3");
+    EXPECT_FALSE(invalid.checkFlags());
+    EXPECT_EQ(invalid.validationErrors(), vector<string>({
+        "invalid value 3 for --even, expected an even number",
+        "invalid value turbo for --mode, expected one of fast|safe|paranoid",
+        "invalid value 1.5 for --ratio, expected a number between 0 and 1",
+        "missing required option --out"}));
+    EXPECT_EQ(invalid.getChoice("--mode").status, Status::invalidValue);
+    EXPECT_EQ(parse("app").getChoice("--mode").status, Status::missingOption);
+
+    // partial matches and trailing garbage aren't valid
+    EXPECT_FALSE(parse("app --out o --ratio 0.5x").validationErrors().empty());
+    EXPECT_FALSE(parse("app --out o --mode fas").validationErrors().empty());
+}
+
+#ifndef MINICMD_NO_EXCEPTIONS
+TEST(ValidatorTest, testPattern) {
+    // the whole value has to match, invalid regexes are reported instead of thrown
+    OptionGroup options(Policy::optional, "options");
+    options.addOption("--id", "ticket id", "", DefaultValue(), Validator::pattern("[A-Z]+-[0-9]{1,5}").value);
+    auto parse = [&](const char* commandLine) {
+        MiniCommander cmd(commandLine);
+        cmd.addOptionGroup(options);
+        return cmd;
+    };
+    EXPECT_TRUE(parse("app --id ABC-123").validationErrors().empty());
+    EXPECT_EQ(parse("app --id abc-123").validationErrors(), vector<string>({
+        "invalid value abc-123 for --id, expected a value matching [A-Z]+-[0-9]{1,5}"}));
+    EXPECT_EQ(parse("app --id abc-123").getChoice("--id").status, Status::invalidValue);
+    EXPECT_FALSE(parse("app --id XABC-123456").validationErrors().empty());
+
+    EXPECT_TRUE(static_cast<bool>(Validator::pattern("(a|b)*?c{2,}[]\\]]")));
+    for (const char* regex : {"(ab", "ab)", "[ab", "*a", "a{2", "a{3,1}", "a\\", "(a)\\2"})
+        EXPECT_EQ(Validator::pattern(regex).status, Status::invalidFormat) << regex;
+}
+#endif
+
+TEST(ValidatorTest, testPerfectHash) {
+    vector<string> names;
+    for (int i = 0; i < 1000; ++i)
+        names.push_back("choice_" + to_string(i));
+    names.push_back("choice_7");  // duplicate
+    minicmd::PerfectHash hash(names);
+    for (int i = 0; i < 1000; ++i)
+        EXPECT_EQ(hash.find(names[i]), i);
+    EXPECT_EQ(hash.find("choice_1000"), -1);
+    EXPECT_EQ(hash.find(""), -1);
+    EXPECT_EQ(minicmd::PerfectHash().find("choice_0"), -1);
+}
+
+TEST(PolicyTest, testRelations) {
+    OptionGroup formats(Policy::exactlyOne, "formats");
+    formats.addOption("--json", "json output", "-j");
+    formats.addOption("--yaml", "yaml output");
+    OptionGroup colors(Policy::atMostOne, "colors");
+    colors.addOption("--color", "colored output");
+    colors.addOption("--no-color", "plain output");
+    OptionGroup options(Policy::optional, "options");
+    options.addOption("--output", "output file");
+    options.addOption("--append", "append to the output file");
+    options.addOption("--quiet", "no output");
+    options.addOption("--verbose", "more output");
+    options.addRequirement("--append", "--output");
+    options.addConflict("--quiet", "--verbose");
+    options.addConflict("--quiet", "--color");  // across groups
+    options.addRequirement("--verbose", "--undeclared");  // never satisfied, but never checked
+    auto parse = [&](const char* commandLine) {
+        MiniCommander cmd(commandLine);
+        cmd.addOptionGroup(formats);
+        cmd.addOptionGroup(colors);
+        cmd.addOptionGroup(options);
+        return cmd;
+    };
+
+    EXPECT_TRUE(parse("app --json --output o --append --verbose").checkFlags());
+    EXPECT_TRUE(parse("app -j --color").checkFlags());
+    EXPECT_EQ(parse("app").validationErrors(), vector<string>({"missing one of the options of [formats]"}));
+    EXPECT_EQ(parse("app --json --yaml --color --no-color --append --quiet --verbose").validationErrors(), vector<string>({
+        "only one of the options of [formats] can be given",
+        "only one of the options of [colors] can be given",
+        "--append requires --output",
+        "--quiet can't be given together with --verbose",
+        "--quiet can't be given together with --color"}));
+    EXPECT_FALSE(parse("app -j --yaml").checkFlags());  // the alternative counts for its option
+
+    // thousands of rules stay linear
+    OptionGroup chain(Policy::optional, "chain");
+    string line = "app --json";
+    for (int i = 0; i < 5000; ++i) {
+        chain.addOption("--option-" + to_string(i));
+        if (i > 0)
+            chain.addRequirement("--option-" + to_string(i), "--option-" + to_string(i - 1));
+        if (i != 2500)
+            line += " --option-" + to_string(i);
+    }
+    MiniCommander cmd(line);
+    cmd.addOptionGroup(formats);
+    cmd.addOptionGroup(chain);
+    EXPECT_EQ(cmd.validationErrors(), vector<string>({"--option-2501 requires --option-2500"}));
+
+    // the allocation-free variant knows the new policies too
+    const int argc = 3;
+    array<const char*, argc> argv_std = {"app", "--json", "--yaml"};
+    StaticCommander<4, 4> sc(argc, (char const* const*)argv_std.data());
+    StaticOptionGroup<2> staticFormats(Policy::exactlyOne, "formats");
+    staticFormats.addOption("--json");
+    staticFormats.addOption("--yaml");
+    sc.addOptionGroup(staticFormats);
+    EXPECT_FALSE(sc.checkFlags());
+}
+
+TEST(MapOptionTest, testMapOption) {
+    OptionGroup options(Policy::optional, "options");
+    options.addMapOption("-D", "define a setting", "--define");
+    options.addOption("-o", "output file");
+    const int argc = 12;
+    array<const char*, argc> argv_std = {"app", "-D", "name=first", "mode=fast", "-o", "out.txt", "--define=name=last",
+                                         "-D", "empty=", "-D", "flag", "x=y"};
+    MiniCommander cmd(argc, (char const* const*)argv_std.data(), true, true);
+    cmd.addOptionGroup(options);
+
+    // all occurrences, split at the first =, the last value wins
+    EXPECT_EQ(string(cmd.getMapValue("-D", "name").value), "last");
+    EXPECT_EQ(string(cmd.getMapValue("-D", "mode").value), "fast");
+    EXPECT_EQ(string(cmd.getMapValue("--define", "mode").value), "fast");
+    EXPECT_EQ(cmd.getMapValue("-D", "empty").status, Status::ok);
+    EXPECT_EQ(string(cmd.getMapValue("-D", "empty").value), "");
+    EXPECT_EQ(string(cmd.getMapValue("-D", "flag").value), "");
+    EXPECT_EQ(string(cmd.getMapValue("-D", "x").value), "y");
+    EXPECT_EQ(cmd.getMapValue("-D", "missing").status, Status::missingOption);
+    EXPECT_EQ(cmd.getMapValue("-o", "out.txt").status, Status::missingOption);
+    EXPECT_EQ(cmd.getParameter("-o"), "out.txt");
+
+    // values are views of the tokens
+    vector<pair<string, string>> entries;
+    for (auto& entry : cmd.getMapEntries("-D"))
+        entries.push_back(make_pair(string(entry.first.data, entry.first.size), string(entry.second.data, entry.second.size)));
+    EXPECT_EQ(entries, (vector<pair<string, string>>{{"empty", ""}, {"flag", ""}, {"mode", "fast"}, {"name", "last"}, {"x", "y"}}));
+
+    // tokenizing is unchanged, other options see the key and value as two parameters
+    MiniCommander split("app --g=c=d -f a=b -D k=v");
+    split.addOptionGroup(options);
+    EXPECT_EQ(split.getMultiParameters("-f"), vector<string>({"a", "b"}));
+    EXPECT_EQ(split.getParameter("--g"), "c=d");
+    EXPECT_EQ(split.getMultiParameters("-D"), vector<string>({"k", "v"}));
+    EXPECT_EQ(split.getMapEntries("-D").size(), 1u);
+    MiniCommander separate("app -D k v");
+    separate.addOptionGroup(options);
+    EXPECT_EQ(separate.getMapEntries("-D").size(), 2u) << "separate arguments are separate keys";
+    MiniCommander restored = MiniCommander::deserialize(split.serialize());
+    restored.addOptionGroup(options);
+    EXPECT_EQ(string(restored.getMapValue("-D", "k").value), "v");
+
+    // hundreds of overrides
+    string line = "app";
+    for (int i = 0; i < 1000; ++i)
+        line += " -D key_" + to_string(i % 500) + "=value_" + to_string(i);
+    MiniCommander many(line);
+    many.addOptionGroup(options);
+    EXPECT_EQ(many.getMapEntries("-D").size(), 500u);
+    for (int i = 0; i < 500; ++i)
+        EXPECT_EQ(string(many.getMapValue("-D", "key_" + to_string(i)).value), "value_" + to_string(i + 500));
+}
+
+TEST(PositionalTest, testTerminator) {
+    const int argc = 10;
+    array<const char*, argc> argv_std = {"app", "build", "in.txt", "-d", "/data", "-x", "--", "-x", "--data=a", "--"};
+    char const* const* argv = (char const* const*)argv_std.data();
+    MiniCommander cmd(argc, argv, true, true);
+    auto optionGroups = makeTestOptionGroups();
+    for (auto& g : optionGroups)
+        cmd.addOptionGroup(g);
+
+    // after --, arguments are operands as they are, not split and never options
+    auto operands = cmd.operands();
+    ASSERT_EQ(operands.size(), 3u);
+    EXPECT_EQ(operands[0], "-x");
+    EXPECT_EQ(operands[1], "--data=a");
+    EXPECT_EQ(operands[2], "--");
+    EXPECT_EQ(cmd.getParameter("--data"), "");
+    EXPECT_TRUE(cmd.getMultiParameters("-x").empty());
+    EXPECT_EQ(cmd.getParameter("-d"), "/data");
+
+    // positional arguments before the first flag and after --
+    ASSERT_EQ(cmd.numPositionals(), 5u);
+    vector<string> positionals;
+    for (size_t i = 0; i < cmd.numPositionals(); ++i)
+        positionals.push_back(cmd.positional(i));
+    EXPECT_EQ(positionals, vector<string>({"build", "in.txt", "-x", "--data=a", "--"}));
+
+    // forwarded with the terminator, canonical form keeps the operands in order
+    ArgvBuilder args = cmd.forwardArguments();
+    vector<string> forwarded;
+    for (size_t i = 0; i < args.size(); ++i)
+        forwarded.push_back(args.get(i));
+    EXPECT_EQ(forwarded, vector<string>({"build", "in.txt", "--", "-x", "--data=a", "--"}));
+    EXPECT_EQ(args.get(3), argv[7]);
+    EXPECT_EQ(cmd.canonicalArguments(), vector<string>({"build", "in.txt", "-d", "/data", "-x", "--", "-x", "--data=a", "--"}));
+
+    MiniCommander restored = MiniCommander::deserialize(cmd.serialize());
+    for (auto& g : optionGroups)
+        restored.addOptionGroup(g);
+    EXPECT_EQ(restored.canonicalHash(), cmd.canonicalHash());
+    EXPECT_EQ(restored.operands().size(), 3u);
+
+    // without --
+    MiniCommander plain("app in.txt -d /data");
+    EXPECT_TRUE(plain.operands().empty());
+
+    // an operand isn't a subcommand
+    MiniCommander git("git -- commit");
+    bool built = false;
+    git.addSubcommand("commit", [&](MiniCommander&) { built = true; });
+    EXPECT_FALSE(built);
+    EXPECT_TRUE(git.subcommand().empty());
+    EXPECT_EQ(git.positional(0), "commit");
 }
 
 int main(int argc, char** argv)